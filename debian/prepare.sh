@@ -13,10 +13,13 @@ _modules="
 	finished
 	fsresizer
 	gen-fstab
+	gen-grubcfg
 	gen-img
 	hostinfo
 	interactiveterminal
+	jobgraph
 	options
+	optionsq
 	make-ab
 	mount
 	notesqml
@@ -24,9 +27,11 @@ _modules="
 	partition
 	preservefiles
 	rawfs
+	size-plan
 	summary
+	trace
 	umount
-	unpackfs
+	unpackfile
 	welcome
 	welcomeq
 	"
@@ -10,6 +10,7 @@
 
 import QtQuick 2.15;
 import calamares.slideshow 1.0;
+import io.calamares.core 1.0;
 
 Presentation
 {
@@ -28,6 +29,26 @@ Presentation
         onTriggered: nextSlide()
     }
 
+    // The time left, as estimated by the trace module (installEta)
+    function etaString(eta) {
+        if (!eta || eta.seconds === undefined || eta.seconds < 0)
+            return "";
+        if (eta.seconds == 0)
+            return qsTr("Almost done");
+        if (eta.seconds < 60)
+            return qsTr("Less than a minute left");
+        var minutes = Math.round(eta.seconds / 60);
+        return minutes == 1 ? qsTr("About a minute left") : qsTr("About %1 minutes left").arg(minutes);
+    }
+
+    Timer {
+        id: etaTimer
+        interval: 1000
+        running: presentation.activatedInCalamares
+        repeat: true
+        onTriggered: etaText.text = etaString(Global.value("installEta"))
+    }
+
     Slide {
         anchors.fill: parent
         anchors.verticalCenterOffset: 0
@@ -74,6 +95,18 @@ Presentation
         }
     }
 
+    Text {
+        id: etaText
+        anchors.right: parent.right
+        anchors.bottom: parent.bottom
+        anchors.margins: 12
+        z: 1
+        visible: text !== ""
+        color: "white"
+        style: Text.Outline
+        styleColor: "black"
+        font.pointSize: 11
+    }
 
     // When this slideshow is loaded as a V1 slideshow, only
     // activatedInCalamares is set, which starts the timer (see above).
@@ -11,6 +11,7 @@
 #
 
 import os
+import sys
 
 import libcalamares
 
@@ -36,6 +37,11 @@ def pretty_status_message():
     return status
 
 
+def set_status(message):
+    global status
+    status = message
+
+
 def mkdir_p(path):
     """Create directory.
 
@@ -48,6 +54,13 @@ sys_prefix = "/usr/share"
 calamares_shared = sys_prefix + "/calamares"
 scriptdir = calamares_shared + "/scripts"
 
+# Commands run from here on show up in the install trace (see the trace module)
+sys.path.append(scriptdir)
+import calamares_progress  # noqa: E402
+import calamares_trace  # noqa: E402
+
+calamares_trace.install()
+
 def is_bootloader(name):
     """
     Check if bootloader is specified.
@@ -110,6 +123,6 @@ def run():
         command = ["echo", "Skipping"]
 
 
-    libcalamares.utils.host_env_process_output(command, None)
+    calamares_progress.run(command, 0.0, 1.0, set_status)
     libcalamares.job.setprogress(1.0)
     return None
@@ -11,6 +11,7 @@
 #
 
 import os
+import sys
 
 import libcalamares
 
@@ -36,6 +37,11 @@ def pretty_status_message():
     return status
 
 
+def set_status(message):
+    global status
+    status = message
+
+
 def mkdir_p(path):
     """
     Create directory.
@@ -47,6 +53,13 @@ sys_prefix = "/usr/share"
 calamares_shared = sys_prefix + "/calamares"
 scriptdir = calamares_shared + "/scripts"
 
+# Commands run from here on show up in the install trace (see the trace module)
+sys.path.append(scriptdir)
+import calamares_progress  # noqa: E402
+import calamares_trace  # noqa: E402
+
+calamares_trace.install()
+
 def is_bootloader(name):
     """
     Check if bootloader is specified.
@@ -95,7 +108,8 @@ def run():
             print("CMDLINE='" + cmdline + "'", file=envCfg)
             print("MODE=normal", file=envCfg)
 
-        command = [scriptdir + "/grubcfg"]
+        # grub.cfg itself is written by the gen-grubcfg module
+        command = None
     elif is_bootloader("refind"):
         bootloader = "refind"
         command = [
@@ -152,6 +166,8 @@ def run():
     with open(os.path.join(root_mount_point, "cmdline.txt"), "w") as cmdlineFile:
         print(cmdline, file=cmdlineFile)
 
-    libcalamares.utils.host_env_process_output(command, None)
+    if command:
+        libcalamares.job.setprogress(0.5)
+        calamares_progress.run(command, 0.5, 1.0, set_status)
     libcalamares.job.setprogress(1.0)
     return None
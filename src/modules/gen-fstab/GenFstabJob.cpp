@@ -0,0 +1,222 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "GenFstabJob.h"
+
+#include "MountInfo.h"
+
+#include "GlobalStorage.h"
+#include "JobQueue.h"
+#include "utils/Logger.h"
+#include "utils/Variant.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <blkid/blkid.h>
+
+static const char fstabHeader[] = R"(# fstab.android: static file system information.
+# FORMAT=0.2
+#
+# Use 'blkid' to print the universally unique identifier for a device; this may
+# be used with UUID= as a more robust way to name devices that works even if
+# disks are added and removed. See fstab(5).
+#
+# <src>    <mnt_point>    <type>    <mnt_flags and options>    <fs_mgr_flags>
+$FS/system$SLOT.img						system$SLOT
+$FS/kernel$SLOT							kernel$SLOT
+$FS/initrd$SLOT.img						initrd$SLOT
+$FS/recovery$SLOT.img					recovery$SLOT
+$FS/misc.img							misc
+
+)";
+
+/// @brief Filesystems without a device of their own (from util-linux, libmount/src/utils.c)
+static const QSet< QString > pseudoFilesystems {
+    "anon_inodefs", "apparmorfs", "autofs",     "bdev",       "binder",    "binfmt_misc", "bpf",       "cgroup",
+    "cgroup2",      "configfs",   "cpuset",     "debugfs",    "devfs",     "devpts",      "devtmpfs",  "dlmfs",
+    "dmabuf",       "drm",        "efivarfs",   "fuse",       "fusectl",   "hugetlbfs",   "ipathfs",   "mqueue",
+    "nfsd",         "none",       "nsfs",       "overlay",    "pipefs",    "proc",        "pstore",    "ramfs",
+    "resctrl",      "rootfs",     "rpc_pipefs", "securityfs", "selinuxfs", "smackfs",     "sockfs",    "spufs",
+    "sysfs",        "tmpfs",      "tracefs",    "vboxsf",     "virtiofs",
+};
+
+/// @brief The mounts below @p root, from /proc/self/mountinfo
+static QList< MountInfo::Mount >
+mountsBelow( const QString& root )
+{
+    QFile file( QStringLiteral( "/proc/self/mountinfo" ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        cWarning() << "Cannot read" << file.fileName() << file.errorString();
+        return {};
+    }
+    return MountInfo::mountsBelow( file.readAll(), root );
+}
+
+/// @brief The value of blkid @p tag (UUID, LABEL, TYPE) of @p device, or empty
+static QString
+blkidTag( blkid_cache cache, const QString& device, const char* tag )
+{
+    char* value = blkid_get_tag_value( cache, tag, QFile::encodeName( device ).constData() );
+    const QString s = value ? QString::fromUtf8( value ) : QString();
+    std::free( value );
+    return s;
+}
+
+GenFstabJob::GenFstabJob( QObject* parent )
+    : Calamares::CppJob( parent )
+{
+}
+
+GenFstabJob::~GenFstabJob() {}
+
+QString
+GenFstabJob::prettyName() const
+{
+    return tr( "Generating fstab." );
+}
+
+Calamares::JobResult
+GenFstabJob::exec()
+{
+    auto* gs = Calamares::JobQueue::instance()->globalStorage();
+    const QString rootPath = gs ? gs->value( "rootMountPoint" ).toString() : QString();
+    if ( rootPath.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "No mount point for root partition" ),
+                                            tr( "globalstorage does not contain a \"rootMountPoint\" key." ) );
+    }
+    const QString root = QFileInfo( rootPath ).canonicalFilePath();
+    if ( root.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "Bad mount point for root partition" ),
+                                            tr( "rootMountPoint is \"%1\", which does not exist." ).arg( rootPath ) );
+    }
+
+    using MountInfo::Mount;
+    const QList< Mount > mounts = mountsBelow( root );
+    if ( std::none_of( mounts.cbegin(), mounts.cend(), [ &root ]( const Mount& m ) { return m.target == root; } ) )
+    {
+        return Calamares::JobResult::error( tr( "Bad mount point for root partition" ),
+                                            tr( "rootMountPoint is \"%1\", which is not a mount point." ).arg( root ) );
+    }
+
+    blkid_cache cache = nullptr;
+    blkid_get_cache( &cache, "/dev/null" );  // Probe afresh, without a cache file
+
+    QString entries;
+    QSet< QString > mountPoints;
+    for ( const Mount& mount : mounts )
+    {
+        // The root filesystem itself is $FS
+        if ( mount.target == root || pseudoFilesystems.contains( mount.fsType ) )
+        {
+            continue;
+        }
+
+        const QString target = mount.target.mid( root.length() + 1 );
+        QString source = mount.source;
+        QString fsType = mount.fsType;
+        QString spec;
+        if ( mount.fsRoot != QStringLiteral( "/" ) && fsType != QStringLiteral( "btrfs" ) )
+        {
+            // A bind mount, of a directory of another mount in the target
+            source = MountInfo::bindSource( mounts, mount, root );
+            if ( source.isEmpty() )
+            {
+                continue;  // Bound in from the host; not valid in the target
+            }
+            if ( source == QStringLiteral( "/" ) + target )
+            {
+                continue;
+            }
+            fsType = QStringLiteral( "none" );
+            spec = MountInfo::mangle( source );
+        }
+        else
+        {
+            if ( fsType == QStringLiteral( "fuseblk" ) )
+            {
+                // Probably NTFS-3g; well-behaved FUSE filesystems say fuse.<type>
+                const QString realType = blkidTag( cache, source, "TYPE" );
+                if ( realType.isEmpty() )
+                {
+                    cWarning() << "Cannot find the filesystem type of" << source << "on" << target;
+                }
+                else
+                {
+                    fsType = realType;
+                }
+            }
+
+            const QString uuid = blkidTag( cache, source, "UUID" );
+            const QString label = blkidTag( cache, source, "LABEL" );
+            entries += QStringLiteral( "# %1" ).arg( source );
+            if ( !label.isEmpty() )
+            {
+                entries += QStringLiteral( " LABEL=%1" ).arg( MountInfo::mangle( label ) );
+            }
+            entries += '\n';
+            spec = uuid.isEmpty() ? MountInfo::mangle( source ) : QStringLiteral( "UUID=%1" ).arg( uuid );
+        }
+
+        const QString mountPoint = MountInfo::androidMountPoint( target );
+        mountPoints.insert( mountPoint );
+        entries += QStringLiteral( "%1\t%2\t%3\t%4\tdefaults\n\n" )
+                       .arg( spec, -20 )
+                       .arg( mountPoint, -10 )
+                       .arg( fsType, -10 )
+                       .arg( QStringLiteral( "defaults" ), -10 );
+    }
+    blkid_put_cache( cache );
+
+    // Directories on the root filesystem stand in for what is not mounted separately
+    if ( !mountPoints.contains( QStringLiteral( "bootloader" ) ) )
+    {
+        entries += QStringLiteral( "$FS/boot bootloader\n" );
+    }
+    if ( !mountPoints.contains( QStringLiteral( "userdata" ) ) )
+    {
+        const bool dataImage = gs->value( "options" ).toString().split( ' ' ).contains( m_dataOption )
+            || QFileInfo::exists( QDir( root ).filePath( QStringLiteral( "data.img" ) ) );
+        entries += dataImage ? QStringLiteral( "$FS/data.img userdata ext4 defaults defaults\n" )
+                             : QStringLiteral( "$FS/data userdata\n" );
+    }
+    if ( QFileInfo( QStringLiteral( "/sys/firmware/efi" ) ).isDir() )
+    {
+        entries += QStringLiteral( "none /sys/firmware/efi/efivars efivarfs defaults defaults\n" );
+    }
+
+    QSaveFile fstab( QDir( root ).filePath( QStringLiteral( "fstab.android" ) ) );
+    if ( !fstab.open( QIODevice::WriteOnly ) || fstab.write( fstabHeader ) < 0 || fstab.write( entries.toUtf8() ) < 0
+         || !fstab.commit() )
+    {
+        return Calamares::JobResult::error(
+            tr( "Could not write fstab" ),
+            tr( "Writing \"%1\" failed: %2" ).arg( fstab.fileName(), fstab.errorString() ) );
+    }
+
+    emit progress( 1.0 );
+    return Calamares::JobResult::ok();
+}
+
+void
+GenFstabJob::setConfigurationMap( const QVariantMap& configurationMap )
+{
+    m_dataOption = Calamares::getString( configurationMap, "dataOption", QStringLiteral( "DATA=data.img" ) );
+}
+
+CALAMARES_PLUGIN_FACTORY_DEFINITION( GenFstabJobFactory, registerPlugin< GenFstabJob >(); )
@@ -0,0 +1,48 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef GENFSTABJOB_H
+#define GENFSTABJOB_H
+
+#include "CppJob.h"
+#include "DllMacro.h"
+#include "utils/PluginFactory.h"
+
+#include <QObject>
+#include <QVariantMap>
+
+/** @brief Writes fstab.android in the target root
+ *
+ * The images ($FS/system$SLOT.img and so on, which Android init expands)
+ * are always listed. The filesystems mounted below the target root, as
+ * read from /proc/self/mountinfo, follow by UUID (from libblkid), and
+ * the boot and data directories on the root filesystem are added when
+ * they have no filesystem of their own.
+ */
+class PLUGINDLLEXPORT GenFstabJob : public Calamares::CppJob
+{
+    Q_OBJECT
+
+public:
+    explicit GenFstabJob( QObject* parent = nullptr );
+    ~GenFstabJob() override;
+
+    QString prettyName() const override;
+
+    Calamares::JobResult exec() override;
+
+    void setConfigurationMap( const QVariantMap& configurationMap ) override;
+
+private:
+    QString m_dataOption;  ///< Selecting this option puts the data on data.img
+};
+
+CALAMARES_PLUGIN_FACTORY_DECLARATION( GenFstabJobFactory )
+
+#endif  // GENFSTABJOB_H
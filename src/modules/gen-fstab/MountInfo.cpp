@@ -0,0 +1,123 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "MountInfo.h"
+
+#include <QDir>
+
+#include <algorithm>
+
+namespace MountInfo
+{
+
+QString
+unmangle( const QByteArray& field )
+{
+    QByteArray out;
+    out.reserve( field.size() );
+    auto isOctal = [ &field ]( int i ) { return field.at( i ) >= '0' && field.at( i ) <= '7'; };
+    for ( int i = 0; i < field.size(); ++i )
+    {
+        if ( field.at( i ) == '\\' && i + 3 < field.size() && isOctal( i + 1 ) && isOctal( i + 2 ) && isOctal( i + 3 ) )
+        {
+            out.append( char( field.mid( i + 1, 3 ).toInt( nullptr, 8 ) ) );
+            i += 3;
+        }
+        else
+        {
+            out.append( field.at( i ) );
+        }
+    }
+    return QString::fromUtf8( out );
+}
+
+QString
+mangle( const QString& s )
+{
+    QString out;
+    for ( const QChar c : s )
+    {
+        if ( c.isSpace() || c == '\\' )
+        {
+            out += QStringLiteral( "\\%1" ).arg( uint( c.unicode() ), 3, 8, QChar( '0' ) );
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out;
+}
+
+QList< Mount >
+mountsBelow( const QByteArray& mountinfo, const QString& root )
+{
+    QList< Mount > mounts;
+    const QString prefix = root.endsWith( '/' ) ? root : root + '/';
+    for ( const QByteArray& line : mountinfo.split( '\n' ) )
+    {
+        // id parent major:minor root mount-point options [optional fields...] - type source super-options
+        const QList< QByteArray > fields = line.split( ' ' );
+        const int separator = fields.indexOf( "-" );
+        if ( fields.count() < 5 || separator < 5 || separator + 2 >= fields.count() )
+        {
+            continue;
+        }
+        Mount m { QString::fromLatin1( fields.at( 2 ) ),
+                  unmangle( fields.at( 3 ) ),
+                  unmangle( fields.at( 4 ) ),
+                  unmangle( fields.at( separator + 1 ) ),
+                  unmangle( fields.at( separator + 2 ) ) };
+        if ( m.target == root || m.target.startsWith( prefix ) )
+        {
+            // A later mount hides the earlier ones on the same mount point, and below it
+            const QString below = m.target + '/';
+            mounts.erase( std::remove_if( mounts.begin(),
+                                          mounts.end(),
+                                          [ &m, &below ]( const Mount& other )
+                                          { return other.target == m.target || other.target.startsWith( below ); } ),
+                          mounts.end() );
+            mounts.append( m );
+        }
+    }
+    return mounts;
+}
+
+QString
+bindSource( const QList< Mount >& mounts, const Mount& mount, const QString& root )
+{
+    auto isParent
+        = [ &mount ]( const Mount& m ) { return m.device == mount.device && m.fsRoot == QStringLiteral( "/" ); };
+    const auto parent = std::find_if( mounts.cbegin(), mounts.cend(), isParent );
+    if ( parent == mounts.cend() )
+    {
+        return QString();
+    }
+    return QStringLiteral( "/" ) + QDir( root ).relativeFilePath( parent->target + mount.fsRoot );
+}
+
+QString
+androidMountPoint( const QString& target )
+{
+    if ( target == QStringLiteral( "boot" ) )
+    {
+        return QStringLiteral( "bootloader" );
+    }
+    if ( target == QStringLiteral( "boot/efi" ) )
+    {
+        return QStringLiteral( "esp" );
+    }
+    if ( target == QStringLiteral( "data" ) )
+    {
+        return QStringLiteral( "userdata" );
+    }
+    return mangle( target );
+}
+
+}  // namespace MountInfo
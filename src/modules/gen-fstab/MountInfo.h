@@ -0,0 +1,56 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef GENFSTAB_MOUNTINFO_H
+#define GENFSTAB_MOUNTINFO_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+/** @brief Reading /proc/self/mountinfo, and naming what is mounted for fstab.android
+ *
+ * These take the text of mountinfo rather than reading it, so that
+ * they can be tested without mounting anything.
+ */
+namespace MountInfo
+{
+/// @brief One line of /proc/self/mountinfo
+struct Mount
+{
+    QString device;  ///< major:minor
+    QString fsRoot;  ///< The directory of the filesystem that is mounted (not / for bind mounts)
+    QString target;
+    QString fsType;
+    QString source;
+};
+
+/// @brief Undoes the octal escapes (\040 for a space) of /proc/self/mountinfo
+QString unmangle( const QByteArray& field );
+/// @brief Escapes whitespace and backslashes the way fstab wants them
+QString mangle( const QString& s );
+
+/** @brief The mounts of @p mountinfo at or below @p root that are visible
+ *
+ * A mount hides the earlier mounts on its mount point, and below it.
+ */
+QList< Mount > mountsBelow( const QByteArray& mountinfo, const QString& root );
+
+/** @brief Where bind mount @p mount comes from, as a path in @p root
+ *
+ * Returns an empty string when the directory is bound in from outside
+ * of @p root, as such a mount means nothing to the installed system.
+ */
+QString bindSource( const QList< Mount >& mounts, const Mount& mount, const QString& root );
+
+/// @brief The Android name for @p target, relative to the root
+QString androidMountPoint( const QString& target );
+}  // namespace MountInfo
+
+#endif  // GENFSTAB_MOUNTINFO_H
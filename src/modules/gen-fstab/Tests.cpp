@@ -0,0 +1,134 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "MountInfo.h"
+
+#include <QtTest/QtTest>
+
+static const char root[] = "/tmp/calamares-root";
+
+/// @brief Mounts for an installation, with things in the way
+static const char mountinfo[] = R"(22 1 0:21 / /proc rw,nosuid - proc proc rw
+30 1 8:2 / /tmp/calamares-root rw,relatime shared:1 - ext4 /dev/sda2 rw
+31 30 8:1 / /tmp/calamares-root/boot rw,relatime shared:2 - vfat /dev/sda1 rw
+32 30 8:3 / /tmp/calamares-root/my\040games rw,relatime - ext4 /dev/sda3 rw
+33 30 8:3 /steam\040lib /tmp/calamares-root/data rw,relatime - ext4 /dev/sda3 rw
+34 30 8:9 /home/user /tmp/calamares-root/home rw,relatime - ext4 /dev/sda9 rw
+35 31 8:4 / /tmp/calamares-root/boot/efi rw,relatime - vfat /dev/sda4 rw
+36 30 8:5 / /tmp/calamares-root/boot rw,relatime - ext4 /dev/disk\134by-label rw
+37 1 8:6 / /tmp/calamares-rootfs rw,relatime - ext4 /dev/sda6 rw
+38 30 0:40 / /tmp/calamares-root/dev rw - devtmpfs udev rw
+this line is not mountinfo
+)";
+
+class GenFstabTests : public QObject
+{
+    Q_OBJECT
+public:
+    GenFstabTests() {}
+    ~GenFstabTests() override {}
+
+private Q_SLOTS:
+    void testUnmangle_data();
+    void testUnmangle();
+    void testMountsBelow();
+    void testBindSource();
+    void testAndroidMountPoint();
+};
+
+void
+GenFstabTests::testUnmangle_data()
+{
+    QTest::addColumn< QByteArray >( "field" );
+    QTest::addColumn< QString >( "path" );
+
+    QTest::newRow( "plain" ) << QByteArray( "/mnt/data" ) << QStringLiteral( "/mnt/data" );
+    QTest::newRow( "space" ) << QByteArray( "/mnt/my\\040games" ) << QStringLiteral( "/mnt/my games" );
+    QTest::newRow( "tab" ) << QByteArray( "/a\\011b" ) << QStringLiteral( "/a\tb" );
+    QTest::newRow( "newline" ) << QByteArray( "/a\\012b" ) << QStringLiteral( "/a\nb" );
+    QTest::newRow( "backslash" ) << QByteArray( "/a\\134b" ) << QStringLiteral( "/a\\b" );
+    QTest::newRow( "at the end" ) << QByteArray( "/a\\040" ) << QStringLiteral( "/a " );
+    QTest::newRow( "too short" ) << QByteArray( "/a\\04" ) << QStringLiteral( "/a\\04" );
+    QTest::newRow( "not octal" ) << QByteArray( "/a\\089" ) << QStringLiteral( "/a\\089" );
+    QTest::newRow( "utf-8" ) << QByteArray( "/m\xc3\xa1y" ) << QStringLiteral( "/máy" );
+}
+
+void
+GenFstabTests::testUnmangle()
+{
+    QFETCH( QByteArray, field );
+    QFETCH( QString, path );
+
+    QCOMPARE( MountInfo::unmangle( field ), path );
+    // fstab escapes the same way, so it reads back
+    QCOMPARE( MountInfo::unmangle( MountInfo::mangle( path ).toUtf8() ), path );
+}
+
+void
+GenFstabTests::testMountsBelow()
+{
+    const auto mounts = MountInfo::mountsBelow( QByteArray( mountinfo ), QLatin1String( root ) );
+
+    QStringList targets;
+    for ( const auto& m : mounts )
+    {
+        targets.append( m.target );
+    }
+    // Not /proc, nor the mount next to the root; the later /boot hides
+    // the earlier one and the ESP on it.
+    QCOMPARE( targets,
+              QStringList( { "/tmp/calamares-root",
+                             "/tmp/calamares-root/my games",
+                             "/tmp/calamares-root/data",
+                             "/tmp/calamares-root/home",
+                             "/tmp/calamares-root/boot",
+                             "/tmp/calamares-root/dev" } ) );
+
+    const auto& boot = mounts.at( 4 );
+    QCOMPARE( boot.device, QStringLiteral( "8:5" ) );
+    QCOMPARE( boot.fsRoot, QStringLiteral( "/" ) );
+    QCOMPARE( boot.fsType, QStringLiteral( "ext4" ) );
+    QCOMPARE( boot.source, QStringLiteral( "/dev/disk\\by-label" ) );
+
+    QCOMPARE( mounts.at( 2 ).fsRoot, QStringLiteral( "/steam lib" ) );
+    QCOMPARE( mounts.at( 5 ).fsType, QStringLiteral( "devtmpfs" ) );
+
+    QVERIFY( MountInfo::mountsBelow( QByteArray(), QLatin1String( root ) ).isEmpty() );
+}
+
+void
+GenFstabTests::testBindSource()
+{
+    const QString rootPath = QLatin1String( root );
+    const auto mounts = MountInfo::mountsBelow( QByteArray( mountinfo ), rootPath );
+    QCOMPARE( mounts.count(), 6 );
+
+    // A directory of another mount in the target
+    QCOMPARE( MountInfo::bindSource( mounts, mounts.at( 2 ), rootPath ), QStringLiteral( "/my games/steam lib" ) );
+    QCOMPARE( MountInfo::mangle( MountInfo::bindSource( mounts, mounts.at( 2 ), rootPath ) ),
+              QStringLiteral( "/my\\040games/steam\\040lib" ) );
+    // Bound in from the host
+    QVERIFY( MountInfo::bindSource( mounts, mounts.at( 3 ), rootPath ).isEmpty() );
+}
+
+void
+GenFstabTests::testAndroidMountPoint()
+{
+    QCOMPARE( MountInfo::androidMountPoint( QStringLiteral( "boot" ) ), QStringLiteral( "bootloader" ) );
+    QCOMPARE( MountInfo::androidMountPoint( QStringLiteral( "boot/efi" ) ), QStringLiteral( "esp" ) );
+    QCOMPARE( MountInfo::androidMountPoint( QStringLiteral( "data" ) ), QStringLiteral( "userdata" ) );
+    QCOMPARE( MountInfo::androidMountPoint( QStringLiteral( "my games" ) ), QStringLiteral( "my\\040games" ) );
+    QCOMPARE( MountInfo::androidMountPoint( QStringLiteral( "data/media" ) ), QStringLiteral( "data/media" ) );
+}
+
+QTEST_GUILESS_MAIN( GenFstabTests )
+
+#include "utils/moc-warnings.h"
+
+#include "Tests.moc"
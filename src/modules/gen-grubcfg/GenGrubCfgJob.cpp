@@ -0,0 +1,484 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "GenGrubCfgJob.h"
+
+#include "GlobalStorage.h"
+#include "JobQueue.h"
+#include "utils/Logger.h"
+#include "utils/Variant.h"
+#include "utils/Yaml.h"
+
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSaveFile>
+
+#include <cstdlib>
+
+#include <blkid/blkid.h>
+
+static const char grubHeader[] = R"(# Written by the Calamares gen-grubcfg module; there is no grub-mkconfig
+# configuration to regenerate it from.
+
+if [ -s $prefix/grubenv ]; then
+  load_env
+fi
+if [ "${next_entry}" ] ; then
+   set default="${next_entry}"
+   set next_entry=
+   save_env next_entry
+   set boot_once=true
+else
+   set default="${saved_entry}"
+fi
+
+if [ x"${feature_menuentry_id}" = xy ]; then
+  menuentry_id_option="--id"
+else
+  menuentry_id_option=""
+fi
+export menuentry_id_option
+
+function savedefault {
+  if [ -z "${boot_once}" ]; then
+    saved_entry="${chosen}"
+    save_env saved_entry
+  fi
+}
+
+function load_video {
+  if [ x$feature_all_video_module = xy ]; then
+    insmod all_video
+  else
+    insmod efi_gop
+    insmod efi_uga
+    insmod ieee1275_fb
+    insmod vbe
+    insmod vga
+    insmod video_bochs
+    insmod video_cirrus
+  fi
+}
+
+)";
+
+/// @brief @p s inside single quotes, for grub.cfg
+static QString
+grubQuote( const QString& s )
+{
+    return QStringLiteral( "'%1'" ).arg( QString( s ).replace( '\'', QStringLiteral( "'\\''" ) ) );
+}
+
+/// @brief @p title as part of a menu entry id
+static QString
+entryId( const QString& title )
+{
+    return QString( title ).replace( ' ', '_' );
+}
+
+/// @brief The GRUB module that reads filesystem @p fs
+static QString
+grubFsModule( const QString& fs )
+{
+    if ( fs.startsWith( QStringLiteral( "ext" ) ) )
+    {
+        return QStringLiteral( "ext2" );
+    }
+    if ( fs == QStringLiteral( "vfat" ) || fs.startsWith( QStringLiteral( "fat" ) ) )
+    {
+        return QStringLiteral( "fat" );
+    }
+    return fs;
+}
+
+/// @brief What grub-mkconfig's prepare_grub_to_access_device writes, one level indented
+static QString
+accessDevice( const QString& uuid, const QString& fs )
+{
+    QString lines = QStringLiteral( "\tinsmod part_gpt\n\tinsmod part_msdos\n" );
+    if ( !fs.isEmpty() )
+    {
+        lines += QStringLiteral( "\tinsmod %1\n" ).arg( grubFsModule( fs ) );
+    }
+    return lines + QStringLiteral( "\tsearch --no-floppy --fs-uuid --set=root %1\n" ).arg( uuid );
+}
+
+static QString
+blkidTag( const QString& device, const char* tag )
+{
+    char* value = blkid_get_tag_value( nullptr, tag, QFile::encodeName( device ).constData() );
+    const QString s = value ? QString::fromUtf8( value ) : QString();
+    std::free( value );
+    return s;
+}
+
+/// @brief The value of @p key in the Java-style properties file @p path
+static QString
+readProperty( const QString& path, const QString& key )
+{
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        return QString();
+    }
+    const QByteArray prefix = key.toUtf8() + '=';
+    while ( !file.atEnd() )
+    {
+        const QByteArray line = file.readLine().trimmed();
+        if ( line.startsWith( prefix ) )
+        {
+            return QString::fromUtf8( line.mid( prefix.length() ) );
+        }
+    }
+    return QString();
+}
+
+/// @brief Runs @p program with @p args, giving up at @p deadline
+static QString
+runUntil( const QString& program, const QStringList& args, const QDeadlineTimer& deadline )
+{
+    QProcess process;
+    process.start( program, args );
+    if ( !process.waitForFinished( int( qMax< qint64 >( 0, deadline.remainingTime() ) ) ) )
+    {
+        process.kill();
+        process.waitForFinished( 1000 );
+        return QString();
+    }
+    return QString::fromLocal8Bit( process.readAllStandardOutput() );
+}
+
+namespace
+{
+/// @brief What is the same for all Android entries
+struct Android
+{
+    QString title;
+    QString access;
+    QString root;  ///< ROOT= for the kernel
+    QString src;
+    QString gfxPayload;
+    bool saveDefault;
+
+    /// @brief The entry titled @p extraTitle, with kernel @p args, indented by @p indent
+    QString entry( const QString& extraTitle, const QString& args, const QString& indent ) const
+    {
+        QString id = QStringLiteral( "Android-%1-$SLOT" ).arg( entryId( title ) );
+        if ( !args.isEmpty() )
+        {
+            id += '-' + entryId( args );
+        }
+
+        QString body;
+        if ( saveDefault )
+        {
+            body += QStringLiteral( "\tsavedefault\n" );
+        }
+        if ( gfxPayload != QStringLiteral( "text" ) )
+        {
+            body += QStringLiteral( "\tload_video\n" );
+        }
+        if ( !gfxPayload.isEmpty() )
+        {
+            body += QStringLiteral( "\tset gfxpayload=%1\n" ).arg( gfxPayload );
+        }
+        body += QStringLiteral( "\tinsmod gzio\n" ) + access;
+        body += QStringLiteral( "\tlinux %1/kernel$SLOT $CMDLINE androidboot.mode=$MODE %2 ROOT=%3 SRC=%1 "
+                                "androidboot.slot_suffix=$SLOT androidboot.bootctrl_bootcfg=/boot/grub/android.cfg\n" )
+                    .arg( src, args, root );
+        body += QStringLiteral( "\tinitrd %1/initrd$SLOT.img\n" ).arg( src );
+
+        const QString fullTitle = extraTitle.isEmpty() ? title : title + QStringLiteral( " - " ) + extraTitle;
+        QString text = QStringLiteral( "menuentry %1 --class blissos --class android --class os "
+                                       "$menuentry_id_option %2 {\n%3}\n" )
+                           .arg( grubQuote( fullTitle ), grubQuote( id ), body );
+        return indent.isEmpty() ? text : indent + text.replace( '\n', '\n' + indent ).chopped( indent.length() );
+    }
+};
+}  // namespace
+
+/** @brief Menu entries for the other operating systems that os-prober found
+ *
+ * @p found is os-prober output: "device:long name:short name:type" lines.
+ */
+static QString
+otherSystems( const QString& found, const QString& rootDevice, const QDeadlineTimer& deadline )
+{
+    // Windows wants to be on the first BIOS disk
+    const QString biosChain = QFileInfo( QStringLiteral( "/sys/firmware/efi" ) ).isDir()
+        ? QString()
+        : QStringLiteral( "\tparttool ${root} hidden-\n\tdrivemap -s (hd0) ${root}\n" );
+    QString entries;
+    for ( const QString& line : found.split( '\n', Qt::SkipEmptyParts ) )
+    {
+        const QStringList fields = line.split( ':' );
+        if ( fields.count() < 4 )
+        {
+            continue;
+        }
+        const QString device = fields.at( 0 ).section( '@', 0, 0 );
+        const QString name = fields.at( 1 ).isEmpty() ? fields.at( 2 ) : fields.at( 1 );
+        const QString type = fields.at( 3 );
+        if ( device == rootDevice )
+        {
+            continue;
+        }
+        const QString title = grubQuote( QStringLiteral( "%1 (on %2)" ).arg( name, device ) );
+        const QString osClass = fields.at( 2 ).toLower().remove( ' ' );
+        const QString uuid = blkidTag( device, "UUID" );
+        const QString access = accessDevice( uuid, blkidTag( device, "TYPE" ) );
+
+        if ( type == QStringLiteral( "efi" ) )
+        {
+            entries += QStringLiteral( "menuentry %1 --class %2 --class os $menuentry_id_option %3 {\n%4"
+                                       "\tchainloader %5\n}\n" )
+                           .arg( title,
+                                 osClass,
+                                 grubQuote( QStringLiteral( "osprober-efi-%1" ).arg( uuid ) ),
+                                 access,
+                                 fields.at( 0 ).section( '@', 1 ) );
+        }
+        else if ( type == QStringLiteral( "chain" ) )
+        {
+            entries += QStringLiteral( "menuentry %1 --class %2 --class os $menuentry_id_option %3 {\n%4%5"
+                                       "\tchainloader +1\n}\n" )
+                           .arg( title,
+                                 osClass,
+                                 grubQuote( QStringLiteral( "osprober-chain-%1" ).arg( uuid ) ),
+                                 access,
+                                 biosChain );
+        }
+        else if ( type == QStringLiteral( "linux" ) )
+        {
+            // root:boot:label:kernel:initrd:parameters, one line per kernel
+            const QString kernels = runUntil( QStringLiteral( "linux-boot-prober" ), { device }, deadline );
+            for ( const QString& kernelLine : kernels.split( '\n', Qt::SkipEmptyParts ) )
+            {
+                const QStringList k = kernelLine.split( ':' );
+                if ( k.count() < 6 )
+                {
+                    continue;
+                }
+                const QString bootUuid = blkidTag( k.at( 1 ), "UUID" );
+                const QString initrd
+                    = k.at( 4 ).isEmpty() ? QString() : QStringLiteral( "\tinitrd %1\n" ).arg( k.at( 4 ) );
+                entries += QStringLiteral( "menuentry %1 --class %2 --class gnu-linux --class os "
+                                           "$menuentry_id_option %3 {\n%4\tlinux %5 %6\n%7}\n" )
+                               .arg( grubQuote( QStringLiteral( "%1, %2 (on %3)" ).arg( name, k.at( 3 ), device ) ),
+                                     osClass,
+                                     grubQuote( QStringLiteral( "osprober-gnulinux-%1-%2" ).arg( k.at( 3 ), uuid ) ),
+                                     accessDevice( bootUuid, blkidTag( k.at( 1 ), "TYPE" ) ),
+                                     k.at( 3 ),
+                                     k.mid( 5 ).join( ':' ),
+                                     initrd );
+            }
+        }
+        else
+        {
+            cDebug() << "No menu entry for" << name << "on" << device << "of type" << type;
+        }
+    }
+    return entries;
+}
+
+GenGrubCfgJob::GenGrubCfgJob( QObject* parent )
+    : Calamares::CppJob( parent )
+{
+}
+
+GenGrubCfgJob::~GenGrubCfgJob() {}
+
+QString
+GenGrubCfgJob::prettyName() const
+{
+    return tr( "Writing the boot menu." );
+}
+
+Calamares::JobResult
+GenGrubCfgJob::exec()
+{
+    auto* gs = Calamares::JobQueue::instance()->globalStorage();
+    const QString rootPath = gs ? gs->value( "rootMountPoint" ).toString() : QString();
+    if ( rootPath.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "No mount point for root partition" ),
+                                            tr( "globalstorage does not contain a \"rootMountPoint\" key." ) );
+    }
+    if ( !QDir( rootPath ).exists() )
+    {
+        return Calamares::JobResult::error( tr( "Bad mount point for root partition" ),
+                                            tr( "rootMountPoint is \"%1\", which does not exist." ).arg( rootPath ) );
+    }
+
+    // The same check as bootcfg, which sets up the other bootloaders
+    const QString bootloader = Calamares::getString( Calamares::YAML::load( m_bootloaderConfig ), "efiBootLoader" );
+    if ( bootloader != QStringLiteral( "grub" ) )
+    {
+        cDebug() << "The bootloader is" << ( bootloader.isEmpty() ? QStringLiteral( "not set" ) : bootloader )
+                 << "in" << m_bootloaderConfig << "- no GRUB menu is written.";
+        emit progress( 1.0 );
+        return Calamares::JobResult::ok();
+    }
+
+    // os-prober is slow; it runs while everything else is done
+    const QDeadlineTimer deadline( m_osProberTimeout * 1000 );
+    QProcess osProber;
+    bool probing = m_osProber;
+    if ( probing )
+    {
+        osProber.start( QStringLiteral( "os-prober" ), QStringList() );
+        probing = osProber.waitForStarted();
+        if ( !probing )
+        {
+            cWarning() << "Cannot run os-prober:" << osProber.errorString() << "- other systems are left out.";
+        }
+    }
+
+    QVariantMap rootPartition;
+    for ( const auto& v : gs->value( "partitions" ).toList() )
+    {
+        if ( v.toMap().value( "mountPoint" ).toString() == QStringLiteral( "/" ) )
+        {
+            rootPartition = v.toMap();
+        }
+    }
+    const QString rootDevice = rootPartition.value( "device" ).toString();
+    QString uuid = rootPartition.value( "uuid" ).toString();
+    if ( uuid.isEmpty() && !rootDevice.isEmpty() )
+    {
+        uuid = blkidTag( rootDevice, "UUID" );
+    }
+    if ( uuid.isEmpty() )
+    {
+        if ( probing )
+        {
+            osProber.kill();
+            osProber.waitForFinished( 1000 );
+        }
+        return Calamares::JobResult::error( tr( "Cannot find the root partition" ),
+                                            tr( "The root partition \"%1\" has no UUID." ).arg( rootDevice ) );
+    }
+
+    QString version = readProperty( m_buildProp, m_versionProperty );
+    Android android { QString( m_title ).replace( QStringLiteral( "@VERSION@" ), version ).trimmed(),
+                      accessDevice( uuid, rootPartition.value( "fs" ).toString() ),
+                      QStringLiteral( "UUID=%1" ).arg( uuid ),
+                      m_src,
+                      m_gfxPayload,
+                      m_saveDefault };
+
+    QString config = QString::fromLatin1( grubHeader );
+    config += QStringLiteral( "set timeout_style=menu\nset timeout=%1\n\n" ).arg( m_timeout );
+    if ( !m_theme.isEmpty() && QFileInfo::exists( QDir( rootPath ).filePath( "boot/grub/" + m_theme ) ) )
+    {
+        config += QStringLiteral( "insmod gfxterm\ninsmod png\nterminal_output gfxterm\nset theme=$prefix/%1\n\n" )
+                      .arg( m_theme );
+    }
+
+    // android.cfg is where the BootCTL HAL updates the slot suffix after an OTA
+    config += QStringLiteral( "source $prefix/android.cfg\nexport SLOT\nexport CMDLINE\nexport MODE\n\n" );
+    config += android.entry( QString(), QString(), QString() ) + '\n';
+
+    config += QStringLiteral( "submenu %1 --class recovery --class blissos --class android --class os "
+                              "$menuentry_id_option %2 {\n" )
+                  .arg( grubQuote( QStringLiteral( "Recovery modes for %1" ).arg( android.title ) ),
+                        grubQuote( QStringLiteral( "Android-%1-Recovery" ).arg( entryId( android.title ) ) ) );
+    Android recovery = android;
+    recovery.title = android.title + QStringLiteral( " - Recovery Mode" );
+    for ( const auto& r : std::as_const( m_recovery ) )
+    {
+        const QString args
+            = QStringLiteral( "androidboot.mode=recovery androidboot.force_normal_boot=0 %1" ).arg( r.args ).trimmed();
+        config += recovery.entry( r.title, args, QStringLiteral( "\t" ) );
+    }
+    config += QStringLiteral( "}\n\n" );
+
+    config += QStringLiteral( "submenu %1 --class submenu --class blissos --class android --class os "
+                              "$menuentry_id_option %2 {\n" )
+                  .arg( grubQuote( QStringLiteral( "Advanced options for %1" ).arg( android.title ) ),
+                        grubQuote( QStringLiteral( "Android-%1-Advanced" ).arg( entryId( android.title ) ) ) );
+    for ( const auto& a : std::as_const( m_advanced ) )
+    {
+        config += android.entry( a.title, a.args, QStringLiteral( "\t" ) );
+    }
+    config += QStringLiteral( "}\n\n" );
+    emit progress( 0.5 );
+
+    if ( probing )
+    {
+        if ( osProber.waitForFinished( int( qMax< qint64 >( 0, deadline.remainingTime() ) ) ) )
+        {
+            config += otherSystems( QString::fromLocal8Bit( osProber.readAllStandardOutput() ), rootDevice, deadline );
+        }
+        else
+        {
+            cWarning() << "os-prober did not finish in" << m_osProberTimeout << "seconds; other systems are left out.";
+            osProber.kill();
+            osProber.waitForFinished( 1000 );
+        }
+    }
+
+    if ( QFileInfo( QStringLiteral( "/sys/firmware/efi" ) ).isDir() )
+    {
+        config += QStringLiteral( "menuentry 'UEFI Firmware Settings' $menuentry_id_option 'uefi-firmware' {\n"
+                                  "\tfwsetup\n}\n" );
+    }
+
+    const QString grubDir = QDir( rootPath ).filePath( QStringLiteral( "boot/grub" ) );
+    QDir().mkpath( grubDir );
+    QSaveFile file( QDir( grubDir ).filePath( QStringLiteral( "grub.cfg" ) ) );
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( config.toUtf8() ) < 0 || !file.commit() )
+    {
+        return Calamares::JobResult::error(
+            tr( "Could not write the boot menu" ),
+            tr( "Writing \"%1\" failed: %2" ).arg( file.fileName(), file.errorString() ) );
+    }
+
+    emit progress( 1.0 );
+    return Calamares::JobResult::ok();
+}
+
+void
+GenGrubCfgJob::setConfigurationMap( const QVariantMap& configurationMap )
+{
+    m_title = Calamares::getString( configurationMap, "title", QStringLiteral( "Android @VERSION@" ) );
+    m_buildProp = Calamares::getString( configurationMap, "buildProp", QStringLiteral( "/system/build.prop" ) );
+    m_versionProperty
+        = Calamares::getString( configurationMap, "versionProperty", QStringLiteral( "ro.bliss.version" ) );
+    m_timeout = Calamares::getInteger( configurationMap, "timeout", 10 );
+    m_saveDefault = Calamares::getBool( configurationMap, "saveDefault", true );
+    m_gfxPayload = Calamares::getString( configurationMap, "gfxPayload", QStringLiteral( "keep" ) );
+    m_src = Calamares::getString( configurationMap, "src" );
+    m_theme = Calamares::getString( configurationMap, "theme" );
+
+    auto bootArgs = [ &configurationMap ]( const QString& key )
+    {
+        QList< BootArgs > list;
+        for ( const auto& v : configurationMap.value( key ).toList() )
+        {
+            const QVariantMap map = v.toMap();
+            list.append( { Calamares::getString( map, "title" ), Calamares::getString( map, "args" ) } );
+        }
+        return list;
+    };
+    m_recovery = bootArgs( QStringLiteral( "recovery" ) );
+    m_advanced = bootArgs( QStringLiteral( "advanced" ) );
+
+    bool ok = false;
+    const QVariantMap osProber = Calamares::getSubMap( configurationMap, "osProber", ok );
+    m_bootloaderConfig = Calamares::getString(
+        configurationMap, "bootloaderConfig", QStringLiteral( "/usr/share/calamares/modules/bootloader.conf" ) );
+    m_osProber = Calamares::getBool( osProber, "enabled", true );
+    m_osProberTimeout = Calamares::getInteger( osProber, "timeout", 20 );
+}
+
+CALAMARES_PLUGIN_FACTORY_DEFINITION( GenGrubCfgJobFactory, registerPlugin< GenGrubCfgJob >(); )
@@ -0,0 +1,73 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef GENGRUBCFGJOB_H
+#define GENGRUBCFGJOB_H
+
+#include "CppJob.h"
+#include "DllMacro.h"
+#include "utils/PluginFactory.h"
+
+#include <QList>
+#include <QObject>
+#include <QVariantMap>
+
+/** @brief Writes /boot/grub/grub.cfg of the target, without grub-mkconfig
+ *
+ * grub-mkconfig runs every script in /etc/grub.d, which probe all the
+ * disks and operating systems, and can take minutes. The Android
+ * entries (normal, recovery and advanced) only need the root partition
+ * from GlobalStorage: the slot, command line and mode are read from
+ * android.cfg by GRUB itself, at boot.
+ *
+ * Other operating systems are found by os-prober, which is started
+ * before anything else is done and gets a time limit; when it runs out,
+ * grub.cfg is written without them.
+ */
+class PLUGINDLLEXPORT GenGrubCfgJob : public Calamares::CppJob
+{
+    Q_OBJECT
+
+public:
+    explicit GenGrubCfgJob( QObject* parent = nullptr );
+    ~GenGrubCfgJob() override;
+
+    QString prettyName() const override;
+
+    Calamares::JobResult exec() override;
+
+    void setConfigurationMap( const QVariantMap& configurationMap ) override;
+
+private:
+    /// @brief An extra menu entry: a title suffix and kernel arguments
+    struct BootArgs
+    {
+        QString title;
+        QString args;
+    };
+
+    QString m_title;  ///< With @VERSION@ for the version from the build properties
+    QString m_buildProp;
+    QString m_versionProperty;
+    QList< BootArgs > m_recovery;
+    QList< BootArgs > m_advanced;
+    int m_timeout = 10;
+    bool m_saveDefault = true;
+    QString m_gfxPayload;
+    QString m_src;  ///< Directory of the kernels and images on the root filesystem
+    QString m_theme;  ///< Relative to /boot/grub, may be empty
+
+    QString m_bootloaderConfig;  ///< Names the bootloader as efiBootLoader; the job only runs for grub
+    bool m_osProber = true;
+    int m_osProberTimeout = 20;  ///< Seconds
+};
+
+CALAMARES_PLUGIN_FACTORY_DECLARATION( GenGrubCfgJobFactory )
+
+#endif  // GENGRUBCFGJOB_H
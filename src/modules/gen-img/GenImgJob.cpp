@@ -0,0 +1,234 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "GenImgJob.h"
+
+#include "GlobalStorage.h"
+#include "JobQueue.h"
+#include "utils/Logger.h"
+#include "utils/Variant.h"
+
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+
+#include <fcntl.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+static constexpr qint64 MiB = 1024 * 1024;
+static constexpr qint64 GiB = 1024 * MiB;
+
+static QString
+errnoString()
+{
+    return QString::fromLocal8Bit( std::strerror( errno ) );
+}
+
+/** @brief Creates the file @p path of @p size bytes, preallocated where possible
+ *
+ * The space is reserved a GiB at a time, so that @p progress can
+ * follow along on filesystems that have to zero the blocks (vfat).
+ * Returns an empty string on success, or an explanation.
+ */
+static QString
+allocateImage( const QString& path, qint64 size, const std::function< void( qreal ) >& progress = nullptr )
+{
+    const int fd = ::open( QFile::encodeName( path ).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+    if ( fd < 0 )
+    {
+        return errnoString();
+    }
+
+    QString error;
+    for ( qint64 offset = 0; offset < size; offset += GiB )
+    {
+        const qint64 length = qMin( GiB, size - offset );
+        if ( ::fallocate( fd, 0, offset, length ) != 0 )
+        {
+            // Filesystems that cannot preallocate get a sparse file
+            if ( offset == 0 && ( errno == EOPNOTSUPP || errno == ENOSYS ) && ::ftruncate( fd, size ) == 0 )
+            {
+                break;
+            }
+            error = errnoString();
+            break;
+        }
+        if ( progress )
+        {
+            progress( qreal( offset + length ) / size );
+        }
+    }
+
+    if ( ::close( fd ) != 0 && error.isEmpty() )
+    {
+        error = errnoString();
+    }
+    if ( !error.isEmpty() )
+    {
+        QFile::remove( path );
+    }
+    return error;
+}
+
+/// @brief Can @p root tell "DATA" and "data" apart? It needs a data/ directory.
+static bool
+isCaseSensitive( const QDir& root )
+{
+    if ( !root.mkdir( QStringLiteral( "DATA" ) ) )
+    {
+        return false;
+    }
+    root.rmdir( QStringLiteral( "DATA" ) );
+    return true;
+}
+
+GenImgJob::GenImgJob( QObject* parent )
+    : Calamares::CppJob( parent )
+{
+}
+
+GenImgJob::~GenImgJob() {}
+
+QString
+GenImgJob::prettyName() const
+{
+    return tr( "Generating needed disk images." );
+}
+
+Calamares::JobResult
+GenImgJob::exec()
+{
+    auto* gs = Calamares::JobQueue::instance()->globalStorage();
+    const QString rootPath = gs ? gs->value( "rootMountPoint" ).toString() : QString();
+    if ( rootPath.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "No mount point for root partition" ),
+                                            tr( "globalstorage does not contain a \"rootMountPoint\" key." ) );
+    }
+    const QDir root( rootPath );
+    if ( !root.exists() )
+    {
+        return Calamares::JobResult::error( tr( "Bad mount point for root partition" ),
+                                            tr( "rootMountPoint is \"%1\", which does not exist." ).arg( rootPath ) );
+    }
+
+    root.mkpath( QStringLiteral( "data" ) );
+    root.mkpath( QStringLiteral( "boot" ) );
+
+    const bool dataImage = gs->value( "options" ).toString().split( ' ' ).contains( m_dataOption )
+        || !isCaseSensitive( root );
+    const QString miscPath = root.filePath( QStringLiteral( "misc.img" ) );
+    if ( !dataImage )
+    {
+        const QString error = allocateImage( miscPath, m_miscSize );
+        if ( !error.isEmpty() )
+        {
+            return Calamares::JobResult::error( tr( "Could not create disk images" ),
+                                                tr( "Creating \"%1\" failed: %2" ).arg( miscPath, error ) );
+        }
+        emit progress( 1.0 );
+        return Calamares::JobResult::ok();
+    }
+
+    // data.img replaces the data directory, and takes up the free space
+    QDir( root.filePath( QStringLiteral( "data" ) ) ).removeRecursively();
+    struct statvfs fs;
+    if ( ::statvfs( QFile::encodeName( rootPath ).constData(), &fs ) != 0 )
+    {
+        return Calamares::JobResult::error(
+            tr( "Could not create disk images" ),
+            tr( "Cannot find the free space on \"%1\": %2" ).arg( rootPath, errnoString() ) );
+    }
+    const qint64 available = qint64( fs.f_bavail ) * qint64( fs.f_frsize );
+    qint64 dataSize = ( ( available - m_dataReserve - m_miscSize ) / MiB ) * MiB;
+
+    // The size-plan module has planned for the filesystem's limits (4 GiB on FAT)
+    const QVariantMap plan = gs->value( "installPlan" ).toMap();
+    if ( plan.value( "dataImage" ).toBool() && plan.value( "dataSize" ).toLongLong() > 0 )
+    {
+        dataSize = qMin( dataSize, plan.value( "dataSize" ).toLongLong() );
+    }
+    if ( dataSize <= 0 )
+    {
+        return Calamares::JobResult::error(
+            tr( "Not enough space for data.img" ),
+            tr( "Only %1 MiB are free, and %2 MiB are kept in reserve." )
+                .arg( available / MiB )
+                .arg( m_dataReserve / MiB ) );
+    }
+
+    const QString dataPath = root.filePath( QStringLiteral( "data.img" ) );
+    cDebug() << "Creating" << dataPath << dataSize / MiB << "MiB";
+    QString error = allocateImage( dataPath, dataSize, [ this ]( qreal p ) { emit progress( 0.9 * p ); } );
+    if ( !error.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "Could not create disk images" ),
+                                            tr( "Creating \"%1\" failed: %2" ).arg( dataPath, error ) );
+    }
+
+    // Lazy initialization leaves the inode tables and journal to the
+    // kernel, on first mount, instead of writing them out here.
+    QProcess mkfs;
+    mkfs.setProcessChannelMode( QProcess::MergedChannels );
+    mkfs.start( m_mkfs,
+                { QStringLiteral( "-F" ),
+                  QStringLiteral( "-q" ),
+                  QStringLiteral( "-L" ),
+                  m_dataLabel,
+                  QStringLiteral( "-E" ),
+                  QStringLiteral( "lazy_itable_init=1,lazy_journal_init=1" ),
+                  dataPath } );
+    // A program that does not start leaves the exit code at 0
+    const bool started = mkfs.waitForStarted( -1 );
+
+    // misc.img is made while mkfs runs
+    error = allocateImage( miscPath, m_miscSize );
+
+    if ( !started )
+    {
+        cWarning() << "Cannot run" << m_mkfs << mkfs.errorString();
+        return Calamares::JobResult::error(
+            tr( "Could not create disk images" ),
+            tr( "Formatting \"%1\" failed: cannot run %2: %3" ).arg( dataPath, m_mkfs, mkfs.errorString() ) );
+    }
+    mkfs.waitForFinished( -1 );
+    if ( mkfs.exitStatus() != QProcess::NormalExit || mkfs.exitCode() != 0 )
+    {
+        const QString output = mkfs.exitStatus() != QProcess::NormalExit ? mkfs.errorString()
+                                                                          : QString::fromLocal8Bit( mkfs.readAll() );
+        cWarning() << m_mkfs << "failed:" << output;
+        return Calamares::JobResult::error( tr( "Could not create disk images" ),
+                                            tr( "Formatting \"%1\" failed: %2" ).arg( dataPath, output ) );
+    }
+    if ( !error.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "Could not create disk images" ),
+                                            tr( "Creating \"%1\" failed: %2" ).arg( miscPath, error ) );
+    }
+
+    emit progress( 1.0 );
+    return Calamares::JobResult::ok();
+}
+
+void
+GenImgJob::setConfigurationMap( const QVariantMap& configurationMap )
+{
+    m_miscSize = Calamares::getInteger( configurationMap, "miscSize", 10 ) * MiB;
+    m_dataReserve = Calamares::getInteger( configurationMap, "dataReserve", 4096 ) * MiB;
+    m_dataOption = Calamares::getString( configurationMap, "dataOption", QStringLiteral( "DATA=data.img" ) );
+    m_dataLabel = Calamares::getString( configurationMap, "dataLabel", QStringLiteral( "userdata" ) );
+    m_mkfs = Calamares::getString( configurationMap, "mkfs", QStringLiteral( "mkfs.ext4" ) );
+}
+
+CALAMARES_PLUGIN_FACTORY_DEFINITION( GenImgJobFactory, registerPlugin< GenImgJob >(); )
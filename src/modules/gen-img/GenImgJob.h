@@ -0,0 +1,54 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef GENIMGJOB_H
+#define GENIMGJOB_H
+
+#include "CppJob.h"
+#include "DllMacro.h"
+#include "utils/PluginFactory.h"
+
+#include <QObject>
+#include <QVariantMap>
+
+/** @brief Creates misc.img, and data.img where it is needed
+ *
+ * misc.img is always made. data.img is made when the *data image*
+ * option is selected, or when the target filesystem cannot hold the
+ * Android data directory because it is case-insensitive. It takes up
+ * the free space, less a reserve (and no more than *installPlan* in
+ * GlobalStorage allows), and is formatted as ext4 with lazy
+ * inode-table and journal initialization, so that formatting does not
+ * write the whole image.
+ */
+class PLUGINDLLEXPORT GenImgJob : public Calamares::CppJob
+{
+    Q_OBJECT
+
+public:
+    explicit GenImgJob( QObject* parent = nullptr );
+    ~GenImgJob() override;
+
+    QString prettyName() const override;
+
+    Calamares::JobResult exec() override;
+
+    void setConfigurationMap( const QVariantMap& configurationMap ) override;
+
+private:
+    qint64 m_miscSize = 0;  ///< Bytes
+    qint64 m_dataReserve = 0;  ///< Bytes left free next to data.img
+    QString m_dataOption;  ///< Selecting this option asks for data.img
+    QString m_dataLabel;
+    QString m_mkfs;  ///< Program that formats data.img as ext4
+};
+
+CALAMARES_PLUGIN_FACTORY_DECLARATION( GenImgJobFactory )
+
+#endif  // GENIMGJOB_H
@@ -0,0 +1,75 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "GenImgJob.h"
+
+#include "GlobalStorage.h"
+#include "JobQueue.h"
+#include "utils/Logger.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+static constexpr qint64 MiB = 1024 * 1024;
+
+class GenImgTests : public QObject
+{
+    Q_OBJECT
+public:
+    GenImgTests() {}
+    ~GenImgTests() override {}
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testMissingMkfs();
+
+private:
+    Calamares::JobQueue* m_jobQueue = nullptr;  // GenImgJob reads GlobalStorage
+};
+
+void
+GenImgTests::initTestCase()
+{
+    Logger::setupLogLevel( Logger::LOGVERBOSE );
+    m_jobQueue = new Calamares::JobQueue( this );
+}
+
+void
+GenImgTests::testMissingMkfs()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+
+    auto* gs = m_jobQueue->globalStorage();
+    gs->insert( "rootMountPoint", dir.path() );
+    gs->insert( "options", QStringLiteral( "DATA=data.img" ) );
+    // A small data.img, whatever is free in the temporary directory
+    gs->insert( "installPlan", QVariantMap { { "dataImage", true }, { "dataSize", 4 * MiB } } );
+
+    GenImgJob job;
+    job.setConfigurationMap( QVariantMap {
+        { "miscSize", 1 },
+        { "dataReserve", 0 },
+        { "mkfs", dir.filePath( QStringLiteral( "no-such-mkfs" ) ) },
+    } );
+    const auto result = job.exec();
+    QVERIFY( !result );
+    QVERIFY( result.details().contains( QStringLiteral( "no-such-mkfs" ) ) );
+    // misc.img is still made, while mkfs would have run
+    QCOMPARE( QFileInfo( dir.filePath( QStringLiteral( "misc.img" ) ) ).size(), MiB );
+}
+
+QTEST_GUILESS_MAIN( GenImgTests )
+
+#include "utils/moc-warnings.h"
+
+#include "Tests.moc"
@@ -0,0 +1,352 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "JobGraphJob.h"
+
+#include "ResourceMeter.h"
+#include "TraceSpool.h"
+
+#include "modulesystem/Module.h"
+#include "modulesystem/ModuleFactory.h"
+#include "modulesystem/ModuleManager.h"
+#include "utils/Logger.h"
+#include "utils/Variant.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <unistd.h>
+
+/** @brief Do @p a and @p b name the same thing?
+ *
+ * Paths (starting with a /) also overlap when one is inside the other.
+ */
+static bool
+overlaps( const QString& a, const QString& b )
+{
+    if ( a == b )
+    {
+        return true;
+    }
+    if ( !a.startsWith( '/' ) || !b.startsWith( '/' ) )
+    {
+        return false;
+    }
+    auto asDirectory = []( const QString& s ) { return s.endsWith( '/' ) ? s : s + '/'; };
+    return a.startsWith( asDirectory( b ) ) || b.startsWith( asDirectory( a ) );
+}
+
+static bool
+overlaps( const QStringList& a, const QStringList& b )
+{
+    for ( const auto& x : a )
+    {
+        for ( const auto& y : b )
+        {
+            if ( overlaps( x, y ) )
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// @brief Measures in the cgroup of the trace module, so that the commands the modules run count too
+static ResourceMeter
+resourceMeter()
+{
+    return ResourceMeter( QFile::decodeName( qgetenv( "CALAMARES_TRACE_CGROUP" ) ) );
+}
+
+/** @brief Adds the run of @p module, from @p start, to the install trace
+ *
+ * The trace module names the spool in CALAMARES_TRACE; without it,
+ * nothing is traced. Each module shows up on the thread it ran on,
+ * with what the whole installer and its child processes used meanwhile
+ * (@p before is from the start), which modules that run at the same
+ * time share.
+ */
+static void
+traceModule( const QString& module, qint64 start, const ResourceUsage& before, bool ok )
+{
+    const QByteArray spool = qgetenv( "CALAMARES_TRACE" );
+    if ( spool.isEmpty() )
+    {
+        return;
+    }
+    QJsonObject args = ResourceMeter::difference( before, resourceMeter().sample() );
+    args.insert( "ok", ok );
+    const QJsonObject event { { "name", module },
+                              { "cat", "module" },
+                              { "ph", "X" },
+                              { "ts", start },
+                              { "dur", TraceSpool::clock() - start },
+                              { "pid", QCoreApplication::applicationPid() },
+                              { "tid", qint64( ::gettid() ) },
+                              { "args", args } };
+    TraceSpool::append( QFile::decodeName( spool ), event );
+}
+
+JobGraphJob::JobGraphJob( QObject* parent )
+    : Calamares::CppJob( parent )
+{
+}
+
+JobGraphJob::~JobGraphJob()
+{
+    qDeleteAll( m_modules );
+}
+
+QString
+JobGraphJob::prettyName() const
+{
+    return tr( "Installing system files." );
+}
+
+Calamares::JobResult
+JobGraphJob::runNode( int index )
+{
+    const Node& node = m_nodes.at( index );
+    const qint64 start = TraceSpool::clock();
+    const ResourceUsage usage = resourceMeter().sample();
+    QElapsedTimer timer;
+    timer.start();
+    for ( const auto& job : node.jobs )
+    {
+        Calamares::JobResult result = job->exec();
+        if ( !result )
+        {
+            traceModule( node.module, start, usage, false );
+            return result;
+        }
+    }
+    cDebug() << "Module" << node.module << "done in" << timer.elapsed() << "ms";
+    traceModule( node.module, start, usage, true );
+    return Calamares::JobResult::ok();
+}
+
+void
+JobGraphJob::reportProgress( int index, qreal progress )
+{
+    QMutexLocker lock( &m_progressMutex );
+
+    m_progress[ index ] = progress;
+    qreal total = 0.0;
+    qreal done = 0.0;
+    for ( int i = 0; i < m_nodes.count(); ++i )
+    {
+        total += m_nodes.at( i ).weight;
+        done += m_nodes.at( i ).weight * m_progress.at( i );
+    }
+    emit this->progress( total > 0 ? done / total : 0.0 );
+}
+
+Calamares::JobResult
+JobGraphJob::exec()
+{
+    if ( !m_loadErrors.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "Bad jobgraph configuration" ),
+                                            tr( "These modules could not be loaded: %1" )
+                                                .arg( m_loadErrors.join( QStringLiteral( ", " ) ) ) );
+    }
+
+    enum class State
+    {
+        Waiting,
+        Running,
+        Done
+    };
+    const int count = m_nodes.count();
+    QVector< State > state( count, State::Waiting );
+    m_progress = QVector< qreal >( count, 0.0 );
+    int running = 0;
+    int done = 0;
+    QString failedModule;
+    QString failedMessage;
+    QString failedDetails;
+
+    QMutex mutex;
+    QWaitCondition changed;
+    QThreadPool pool;
+    pool.setMaxThreadCount( m_concurrency );
+
+    // Called with the mutex held
+    auto finish = [ & ]( int index, const Calamares::JobResult& result )
+    {
+        state[ index ] = State::Done;
+        --running;
+        ++done;
+        if ( !result && failedModule.isEmpty() )
+        {
+            failedModule = m_nodes.at( index ).module;
+            failedMessage = result.message();
+            failedDetails = result.details();
+        }
+        changed.wakeAll();
+    };
+    auto isReady = [ & ]( int index )
+    {
+        if ( state.at( index ) != State::Waiting )
+        {
+            return false;
+        }
+        for ( int i : m_nodes.at( index ).after )
+        {
+            if ( state.at( i ) != State::Done )
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    QMutexLocker lock( &mutex );
+    while ( done < count && ( failedModule.isEmpty() || running > 0 ) )
+    {
+        int serial = -1;
+        for ( int i = 0; failedModule.isEmpty() && i < count && running < m_concurrency; ++i )
+        {
+            if ( !isReady( i ) )
+            {
+                continue;
+            }
+            if ( m_nodes.at( i ).serial )
+            {
+                serial = serial < 0 ? i : serial;
+                continue;
+            }
+            state[ i ] = State::Running;
+            ++running;
+            cDebug() << "Starting module" << m_nodes.at( i ).module << "on the thread pool.";
+            pool.start(
+                [ &, i ]()
+                {
+                    Calamares::JobResult result = runNode( i );
+                    QMutexLocker workerLock( &mutex );
+                    finish( i, result );
+                } );
+        }
+
+        if ( serial >= 0 && running < m_concurrency )
+        {
+            state[ serial ] = State::Running;
+            ++running;
+            cDebug() << "Starting module" << m_nodes.at( serial ).module;
+            lock.unlock();
+            Calamares::JobResult result = runNode( serial );
+            lock.relock();
+            finish( serial, result );
+        }
+        else if ( running > 0 )
+        {
+            changed.wait( &mutex );
+        }
+        else
+        {
+            break;  // Only reachable after a failure, with nothing left running
+        }
+    }
+    lock.unlock();
+    pool.waitForDone();
+
+    if ( !failedModule.isEmpty() )
+    {
+        cWarning() << "Module" << failedModule << "failed:" << failedMessage;
+        return Calamares::JobResult::error( failedMessage, failedDetails );
+    }
+    emit progress( 1.0 );
+    return Calamares::JobResult::ok();
+}
+
+void
+JobGraphJob::setConfigurationMap( const QVariantMap& configurationMap )
+{
+    m_concurrency = qMax( 1, Calamares::getInteger( configurationMap, "concurrency", 2 ) );
+
+    auto* manager = Calamares::ModuleManager::instance();
+    for ( const auto& v : configurationMap.value( "jobs" ).toList() )
+    {
+        const QVariantMap map = v.toMap();
+        Node node;
+        node.module = Calamares::getString( map, "module" );
+        node.reads = Calamares::getStringList( map, "reads" );
+        node.writes = Calamares::getStringList( map, "writes" );
+        node.weight = qMax( 0.0, Calamares::getDouble( map, "weight", 1.0 ) );
+
+        const auto descriptor
+            = manager ? manager->moduleDescriptor( node.module ) : Calamares::ModuleSystem::Descriptor();
+        if ( !descriptor.isValid() )
+        {
+            cWarning() << "jobgraph entry" << map << "does not name a known module.";
+            m_loadErrors.append( node.module );
+            continue;
+        }
+        const QString configFile
+            = Calamares::getString( map, "config", QStringLiteral( "%1.conf" ).arg( node.module ) );
+        Calamares::Module* module
+            = Calamares::moduleFromDescriptor( descriptor, node.module, configFile, descriptor.directory() );
+        if ( module )
+        {
+            module->loadSelf();
+        }
+        if ( !module || !module->isLoaded() )
+        {
+            cWarning() << "jobgraph could not load module" << node.module;
+            m_loadErrors.append( node.module );
+            delete module;
+            continue;
+        }
+        m_modules.append( module );
+
+        node.jobs = module->jobs();
+        node.serial = false;
+        for ( const auto& job : std::as_const( node.jobs ) )
+        {
+            // Only C++ jobs are known to be safe on another thread
+            node.serial = node.serial || !qobject_cast< Calamares::CppJob* >( job.data() );
+        }
+
+        const int index = m_nodes.count();
+        for ( int i = 0; i < index; ++i )
+        {
+            const Node& earlier = m_nodes.at( i );
+            if ( overlaps( earlier.writes, node.reads + node.writes ) || overlaps( earlier.reads, node.writes ) )
+            {
+                node.after.append( i );
+            }
+        }
+        const qreal jobCount = node.jobs.count();
+        for ( int j = 0; j < node.jobs.count(); ++j )
+        {
+            connect( node.jobs.at( j ).data(),
+                     &Calamares::Job::progress,
+                     this,
+                     [ this, index, j, jobCount ]( qreal p ) { reportProgress( index, ( j + p ) / jobCount ); },
+                     Qt::DirectConnection );
+        }
+        m_nodes.append( node );
+    }
+
+    m_progress = QVector< qreal >( m_nodes.count(), 0.0 );
+    if ( m_nodes.isEmpty() && m_loadErrors.isEmpty() )
+    {
+        cWarning() << "No *jobs* in jobgraph configuration.";
+    }
+}
+
+CALAMARES_PLUGIN_FACTORY_DEFINITION( JobGraphJobFactory, registerPlugin< JobGraphJob >(); )
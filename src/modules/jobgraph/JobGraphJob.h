@@ -0,0 +1,82 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef JOBGRAPHJOB_H
+#define JOBGRAPHJOB_H
+
+#include "CppJob.h"
+#include "DllMacro.h"
+#include "Job.h"
+#include "utils/PluginFactory.h"
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+namespace Calamares
+{
+class Module;
+}  // namespace Calamares
+
+/** @brief Runs several exec modules, in parallel where they do not conflict
+ *
+ * The job queue of Calamares runs one job after the other. This job
+ * loads a list of modules itself, and runs their jobs as a graph:
+ * each module declares what it reads and writes (paths in the target
+ * system, GlobalStorage keys, or other shared names), and a module
+ * waits only for the modules listed before it that it conflicts with.
+ *
+ * C++ jobs run on a thread pool of configurable size. All other jobs
+ * (Python in particular, which has one interpreter) run one at a time
+ * on the thread of this job, which is the thread they would run on
+ * anyway. Progress is the weighted sum of the progress of the modules.
+ */
+class PLUGINDLLEXPORT JobGraphJob : public Calamares::CppJob
+{
+    Q_OBJECT
+
+public:
+    explicit JobGraphJob( QObject* parent = nullptr );
+    ~JobGraphJob() override;
+
+    QString prettyName() const override;
+
+    Calamares::JobResult exec() override;
+
+    void setConfigurationMap( const QVariantMap& configurationMap ) override;
+
+private:
+    struct Node
+    {
+        QString module;
+        QStringList reads;
+        QStringList writes;
+        qreal weight = 1.0;
+        Calamares::JobList jobs;
+        QList< int > after;  ///< Indexes of the nodes that must finish first
+        bool serial = false;  ///< Runs on the thread of this job
+    };
+
+    Calamares::JobResult runNode( int index );
+    void reportProgress( int index, qreal progress );
+
+    QList< Node > m_nodes;
+    QList< Calamares::Module* > m_modules;
+    QStringList m_loadErrors;
+    QVector< qreal > m_progress;  ///< Per node, guarded by m_progressMutex
+    QMutex m_progressMutex;
+    int m_concurrency = 2;
+};
+
+CALAMARES_PLUGIN_FACTORY_DECLARATION( JobGraphJobFactory )
+
+#endif  // JOBGRAPHJOB_H
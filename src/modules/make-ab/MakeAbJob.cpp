@@ -0,0 +1,160 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "MakeAbJob.h"
+
+#include "Slots.h"
+
+#include "GlobalStorage.h"
+#include "JobQueue.h"
+#include "utils/Logger.h"
+#include "utils/Variant.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <sys/statvfs.h>
+
+static constexpr qint64 MiB = 1024 * 1024;
+
+MakeAbJob::MakeAbJob( QObject* parent )
+    : Calamares::CppJob( parent )
+{
+}
+
+MakeAbJob::~MakeAbJob() {}
+
+QString
+MakeAbJob::prettyName() const
+{
+    return tr( "Creating A/B slots." );
+}
+
+Calamares::JobResult
+MakeAbJob::exec()
+{
+    auto* gs = Calamares::JobQueue::instance()->globalStorage();
+    const QString root = gs ? gs->value( "rootMountPoint" ).toString() : QString();
+    if ( root.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "No mount point for root partition" ),
+                                            tr( "globalstorage does not contain a \"rootMountPoint\" key." ) );
+    }
+    if ( !QDir( root ).exists() )
+    {
+        return Calamares::JobResult::error( tr( "Bad mount point for root partition" ),
+                                            tr( "rootMountPoint is \"%1\", which does not exist." ).arg( root ) );
+    }
+
+    if ( m_entries.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "Bad make-ab configuration" ),
+                                            tr( "There is no configuration information." ) );
+    }
+
+    // Bail out before touching anything when there are obvious problems
+    QList< Slots::Plan > plans;
+    qint64 needed = 0;
+    for ( const auto& entry : std::as_const( m_entries ) )
+    {
+        const QFileInfo source( QDir( root ).filePath( entry.file ) );
+        Slots::Plan plan = Slots::plan(
+            source.filePath(), entry.size >= 0 ? entry.size : source.size(), entry.populate );
+
+        if ( !source.isFile() )
+        {
+            return Calamares::JobResult::error( tr( "Bad make-ab configuration" ),
+                                                tr( "The source file \"%1\" does not exist." ).arg( plan.source ) );
+        }
+        if ( QFileInfo::exists( plan.slotA ) || QFileInfo::exists( plan.slotB ) )
+        {
+            return Calamares::JobResult::error( tr( "Bad make-ab configuration" ),
+                                                tr( "The slots of \"%1\" already exist." ).arg( plan.source ) );
+        }
+        if ( m_preallocate && !plan.populate )
+        {
+            needed += plan.size;
+        }
+        plans.append( plan );
+    }
+
+    struct statvfs fs;
+    if ( needed > 0 && ::statvfs( QFile::encodeName( root ).constData(), &fs ) == 0
+         && needed > qint64( fs.f_bavail ) * qint64( fs.f_frsize ) )
+    {
+        return Calamares::JobResult::error(
+            tr( "Not enough space for A/B slots" ),
+            tr( "The B slots need %1 MiB, but only %2 MiB are free." )
+                .arg( needed / MiB )
+                .arg( qint64( fs.f_bavail ) * qint64( fs.f_frsize ) / MiB ) );
+    }
+
+    // Everything that can fail slowly happens to hidden, partial files ..
+    const int steps = plans.count() + 1;
+    for ( int i = 0; i < plans.count(); ++i )
+    {
+        const Slots::Plan& plan = plans.at( i );
+        cDebug() << "Creating B slot" << plan.slotB << plan.size / MiB << "MiB" << ( plan.populate ? "populated" : "" );
+        const QString error = Slots::create( plan, m_preallocate );
+        if ( !error.isEmpty() )
+        {
+            Slots::removePartials( plans );
+            return Calamares::JobResult::error( tr( "Could not create A/B slots" ),
+                                                tr( "Creating \"%1\" failed: %2" ).arg( plan.slotB, error ) );
+        }
+        emit progress( qreal( i + 1 ) / steps );
+    }
+
+    // .. and then renaming, which is quick and can be undone.
+    QString error;
+    const int failed = Slots::renameAll( plans, error );
+    if ( failed >= 0 )
+    {
+        return Calamares::JobResult::error(
+            tr( "Could not create A/B slots" ),
+            tr( "Renaming \"%1\" failed: %2" ).arg( plans.at( failed ).source, error ) );
+    }
+
+    emit progress( 1.0 );
+    return Calamares::JobResult::ok();
+}
+
+void
+MakeAbJob::setConfigurationMap( const QVariantMap& configurationMap )
+{
+    m_entries.clear();
+    m_preallocate = Calamares::getBool( configurationMap, "preallocate", true );
+
+    for ( const auto& v : configurationMap.value( "make-ab" ).toList() )
+    {
+        const QVariantMap map = v.toMap();
+        Entry entry;
+        entry.file = Calamares::getString( map, "file" );
+        entry.populate = Calamares::getBool( map, "populate", false );
+        // "auto" sizes the B slot like the A slot, as installed
+        const bool autoSize = map.value( "size" ).toString() == QStringLiteral( "auto" );
+        if ( map.contains( "size" ) && !autoSize )
+        {
+            entry.size = Calamares::getInteger( map, "size", 0 ) * MiB;
+        }
+        if ( entry.file.isEmpty() || ( entry.size < 0 && !entry.populate && !autoSize ) )
+        {
+            cWarning() << "make-ab entry" << map << "needs a *file* and a *size* (or *populate*).";
+            continue;
+        }
+        m_entries.append( entry );
+    }
+    if ( m_entries.isEmpty() )
+    {
+        cWarning() << "No *make-ab* entries in job configuration.";
+    }
+}
+
+CALAMARES_PLUGIN_FACTORY_DEFINITION( MakeAbJobFactory, registerPlugin< MakeAbJob >(); )
@@ -0,0 +1,61 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef MAKEABJOB_H
+#define MAKEABJOB_H
+
+#include "CppJob.h"
+#include "DllMacro.h"
+#include "utils/PluginFactory.h"
+
+#include <QList>
+#include <QObject>
+#include <QVariantMap>
+
+/** @brief Turns installed files into A/B slot pairs
+ *
+ * Each configured file (relative to the root mount point) is renamed
+ * to its A slot (system.img becomes system_a.img) and gets a B slot
+ * next to it (system_b.img). The B slot is either empty, of the
+ * configured size, or -- with *populate* -- a copy of the A slot,
+ * which is a reflink on copy-on-write filesystems.
+ *
+ * All B slots are created first, as hidden temporary files; only when
+ * all of them exist are the files renamed into place. If anything
+ * fails, everything done so far is undone.
+ */
+class PLUGINDLLEXPORT MakeAbJob : public Calamares::CppJob
+{
+    Q_OBJECT
+
+public:
+    explicit MakeAbJob( QObject* parent = nullptr );
+    ~MakeAbJob() override;
+
+    QString prettyName() const override;
+
+    Calamares::JobResult exec() override;
+
+    void setConfigurationMap( const QVariantMap& configurationMap ) override;
+
+private:
+    struct Entry
+    {
+        QString file;  ///< Relative to the root mount point
+        qint64 size = -1;  ///< In bytes; -1 for "same as the A slot"
+        bool populate = false;
+    };
+
+    QList< Entry > m_entries;
+    bool m_preallocate = true;
+};
+
+CALAMARES_PLUGIN_FACTORY_DECLARATION( MakeAbJobFactory )
+
+#endif  // MAKEABJOB_H
@@ -0,0 +1,160 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "Slots.h"
+
+#include "utils/Logger.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+static QString
+errnoString()
+{
+    return QString::fromLocal8Bit( std::strerror( errno ) );
+}
+
+namespace Slots
+{
+
+QString
+slotPath( const QString& path, const char* slot )
+{
+    const QFileInfo fi( path );
+    const QString name = fi.fileName();
+    const int dot = name.lastIndexOf( '.' );
+    const QString suffix = QStringLiteral( "_" ) + QLatin1String( slot );
+    return fi.dir().filePath( dot > 0 ? name.left( dot ) + suffix + name.mid( dot ) : name + suffix );
+}
+
+Plan
+plan( const QString& source, qint64 size, bool populate )
+{
+    Plan plan;
+    plan.source = source;
+    plan.slotA = slotPath( source, "a" );
+    plan.slotB = slotPath( source, "b" );
+    const QFileInfo slotB( plan.slotB );
+    plan.partial = slotB.dir().filePath( QStringLiteral( ".%1.part" ).arg( slotB.fileName() ) );
+    plan.size = size;
+    plan.populate = populate;
+    return plan;
+}
+
+QString
+create( const Plan& plan, bool preallocate )
+{
+    const int out
+        = ::open( QFile::encodeName( plan.partial ).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644 );
+    if ( out < 0 )
+    {
+        return errnoString();
+    }
+
+    bool cloned = false;
+    if ( plan.populate )
+    {
+        const int in = ::open( QFile::encodeName( plan.source ).constData(), O_RDONLY | O_CLOEXEC );
+        if ( in >= 0 && ::ioctl( out, FICLONE, in ) == 0 )
+        {
+            cloned = true;
+        }
+        else
+        {
+            cWarning() << "Cannot reflink" << plan.source << errnoString() << "- its B slot starts empty.";
+        }
+        if ( in >= 0 )
+        {
+            ::close( in );
+        }
+    }
+
+    QString error;
+    if ( cloned )
+    {
+        // A clone is as large as its source; only ever grow it.
+        if ( plan.size > QFileInfo( plan.source ).size() && ::ftruncate( out, plan.size ) != 0 )
+        {
+            error = errnoString();
+        }
+    }
+    else if ( preallocate && ::fallocate( out, 0, 0, plan.size ) == 0 )
+    {
+        // Reserved, so the slot cannot run out of space later
+    }
+    else if ( preallocate && errno != EOPNOTSUPP && errno != ENOSYS )
+    {
+        error = errnoString();
+    }
+    else if ( ::ftruncate( out, plan.size ) != 0 )
+    {
+        // Sparse, as the filesystem cannot preallocate
+        error = errnoString();
+    }
+
+    if ( ::close( out ) != 0 && error.isEmpty() )
+    {
+        error = errnoString();
+    }
+    return error;
+}
+
+void
+removePartials( const QList< Plan >& plans )
+{
+    for ( const auto& plan : plans )
+    {
+        ::unlink( QFile::encodeName( plan.partial ).constData() );
+    }
+}
+
+bool
+renameFile( const QString& from, const QString& to )
+{
+    return ::rename( QFile::encodeName( from ).constData(), QFile::encodeName( to ).constData() ) == 0;
+}
+
+int
+renameAll( const QList< Plan >& plans, QString& error, const Rename& rename )
+{
+    for ( int i = 0; i < plans.count(); ++i )
+    {
+        const Plan& plan = plans.at( i );
+        const bool renamedA = rename( plan.source, plan.slotA );
+        if ( renamedA && rename( plan.partial, plan.slotB ) )
+        {
+            continue;
+        }
+
+        error = errnoString();
+        if ( renamedA )
+        {
+            rename( plan.slotA, plan.source );
+        }
+        for ( int j = i - 1; j >= 0; --j )
+        {
+            rename( plans.at( j ).slotB, plans.at( j ).partial );
+            rename( plans.at( j ).slotA, plans.at( j ).source );
+        }
+        removePartials( plans );
+        return i;
+    }
+    return -1;
+}
+
+}  // namespace Slots
@@ -0,0 +1,65 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef MAKEAB_SLOTS_H
+#define MAKEAB_SLOTS_H
+
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+/** @brief The file operations of make-ab, without the job around them
+ *
+ * B slots are made at hidden partial paths first (create()); when all
+ * of them exist, the files are renamed into place (renameAll()), which
+ * is quick and can be undone.
+ */
+namespace Slots
+{
+/// @brief What happens to one configured file
+struct Plan
+{
+    QString source;
+    QString slotA;
+    QString slotB;
+    QString partial;  ///< The B slot while it is being made
+    qint64 size = 0;
+    bool populate = false;
+};
+
+/// @brief @p path with @p slot added to the file name, before the extension (system.img -> system_a.img)
+QString slotPath( const QString& path, const char* slot );
+
+/// @brief The plan for @p source, with a B slot of @p size bytes
+Plan plan( const QString& source, qint64 size, bool populate );
+
+/** @brief Creates the B slot of @p plan at its partial path
+ *
+ * Returns an empty string on success, or an explanation.
+ */
+QString create( const Plan& plan, bool preallocate );
+
+/// @brief Removes the partial B slots of @p plans, where there are any
+void removePartials( const QList< Plan >& plans );
+
+using Rename = std::function< bool( const QString& from, const QString& to ) >;
+bool renameFile( const QString& from, const QString& to );
+
+/** @brief Renames the sources to A slots and the partials to B slots
+ *
+ * If a rename fails, all renames before it are undone and the partials
+ * are removed, so the files are as they were before create(). Returns
+ * the index of the plan that failed, with the reason in @p error, or -1.
+ * @p rename is there for the tests.
+ */
+int renameAll( const QList< Plan >& plans, QString& error, const Rename& rename = renameFile );
+}  // namespace Slots
+
+#endif  // MAKEAB_SLOTS_H
@@ -0,0 +1,171 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "Slots.h"
+
+#include "utils/Logger.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+#include <cerrno>
+
+static constexpr qint64 MiB = 1024 * 1024;
+
+/// @brief Makes @p path with @p data in it
+static bool
+makeFile( const QString& path, const QByteArray& data )
+{
+    QFile f( path );
+    return f.open( QIODevice::WriteOnly ) && f.write( data ) == data.size();
+}
+
+static QByteArray
+contents( const QString& path )
+{
+    QFile f( path );
+    return f.open( QIODevice::ReadOnly ) ? f.readAll() : QByteArray();
+}
+
+/// @brief Plans for system.img and vendor.img in @p dir, which are made with their names as contents
+static QList< Slots::Plan >
+makePlans( const QTemporaryDir& dir )
+{
+    QList< Slots::Plan > plans;
+    for ( const char* name : { "system.img", "vendor.img" } )
+    {
+        const QString source = dir.filePath( QLatin1String( name ) );
+        if ( makeFile( source, QByteArray( name ) ) )
+        {
+            plans.append( Slots::plan( source, MiB, false ) );
+        }
+    }
+    return plans;
+}
+
+/// @brief The files in @p dir, hidden ones included
+static QStringList
+files( const QTemporaryDir& dir )
+{
+    return QDir( dir.path() ).entryList( QDir::Files | QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot, QDir::Name );
+}
+
+class MakeAbTests : public QObject
+{
+    Q_OBJECT
+public:
+    MakeAbTests() {}
+    ~MakeAbTests() override {}
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testSlotPath();
+    void testCreate();
+    void testCreateFails();
+    void testRenameFails();
+};
+
+void
+MakeAbTests::initTestCase()
+{
+    Logger::setupLogLevel( Logger::LOGVERBOSE );
+}
+
+void
+MakeAbTests::testSlotPath()
+{
+    QCOMPARE( Slots::slotPath( QStringLiteral( "/data/system.img" ), "a" ), QStringLiteral( "/data/system_a.img" ) );
+    QCOMPARE( Slots::slotPath( QStringLiteral( "/data/system" ), "b" ), QStringLiteral( "/data/system_b" ) );
+    QCOMPARE( Slots::slotPath( QStringLiteral( "/data/.img" ), "b" ), QStringLiteral( "/data/.img_b" ) );
+
+    const auto plan = Slots::plan( QStringLiteral( "/data/system.img" ), MiB, true );
+    QCOMPARE( plan.partial, QStringLiteral( "/data/.system_b.img.part" ) );
+}
+
+void
+MakeAbTests::testCreate()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const auto plans = makePlans( dir );
+    QCOMPARE( plans.count(), 2 );
+
+    for ( const auto& plan : plans )
+    {
+        QCOMPARE( Slots::create( plan, true ), QString() );
+        QCOMPARE( QFileInfo( plan.partial ).size(), MiB );
+    }
+    QString error;
+    QCOMPARE( Slots::renameAll( plans, error ), -1 );
+    QCOMPARE( files( dir ),
+              QStringList( { "system_a.img", "system_b.img", "vendor_a.img", "vendor_b.img" } ) );
+    QCOMPARE( contents( plans.at( 0 ).slotA ), QByteArray( "system.img" ) );
+    QCOMPARE( QFileInfo( plans.at( 1 ).slotB ).size(), MiB );
+}
+
+void
+MakeAbTests::testCreateFails()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const auto plans = makePlans( dir );
+    QCOMPARE( plans.count(), 2 );
+
+    // Something is in the way of the second partial, so it cannot be made
+    QVERIFY( QDir().mkdir( plans.at( 1 ).partial ) );
+    QCOMPARE( Slots::create( plans.at( 0 ), false ), QString() );
+    QVERIFY( !Slots::create( plans.at( 1 ), false ).isEmpty() );
+    QVERIFY( QDir().rmdir( plans.at( 1 ).partial ) );
+
+    Slots::removePartials( plans );
+    QCOMPARE( files( dir ), QStringList( { "system.img", "vendor.img" } ) );
+    QCOMPARE( contents( plans.at( 1 ).source ), QByteArray( "vendor.img" ) );
+}
+
+void
+MakeAbTests::testRenameFails()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const auto plans = makePlans( dir );
+    QCOMPARE( plans.count(), 2 );
+    for ( const auto& plan : plans )
+    {
+        QCOMPARE( Slots::create( plan, false ), QString() );
+    }
+
+    // The B slot of the second file cannot be renamed into place, after
+    // both files of the first and the A slot of the second are
+    const QString failing = plans.at( 1 ).partial;
+    auto rename = [ &failing ]( const QString& from, const QString& to )
+    {
+        if ( from == failing )
+        {
+            errno = EXDEV;
+            return false;
+        }
+        return Slots::renameFile( from, to );
+    };
+    QString error;
+    QCOMPARE( Slots::renameAll( plans, error, rename ), 1 );
+    QVERIFY( !error.isEmpty() );
+    QCOMPARE( files( dir ), QStringList( { "system.img", "vendor.img" } ) );
+    QCOMPARE( contents( plans.at( 0 ).source ), QByteArray( "system.img" ) );
+    QCOMPARE( contents( plans.at( 1 ).source ), QByteArray( "vendor.img" ) );
+}
+
+QTEST_GUILESS_MAIN( MakeAbTests )
+
+#include "utils/moc-warnings.h"
+
+#include "Tests.moc"
@@ -13,6 +13,9 @@
 #include "Config.h"
 
 #include "LoaderQueue.h"
+#include "OptionListModel.h"
+#include "OptionProbe.h"
+#include "OptionsSnapshot.h"
 
 #include "GlobalStorage.h"
 #include "JobQueue.h"
@@ -22,7 +25,10 @@
 #include "utils/Retranslator.h"
 #include "utils/Variant.h"
 
+#include <QFile>
+#include <QFutureWatcher>
 #include <QNetworkReply>
+#include <QtConcurrent/QtConcurrentMap>
 
 Config::Config( QObject* parent )
     : QObject( parent )
@@ -39,6 +45,8 @@ Config::retranslate()
     emit statusChanged( status() );
     emit sidebarLabelChanged( sidebarLabel() );
     emit titleLabelChanged( titleLabel() );
+    emit presetsChanged();
+    m_model->setLocale( Calamares::translatorLocaleName().name );
 }
 
 QString
@@ -69,6 +77,16 @@ Config::setStatus( Status s )
     emit statusChanged( status() );
 }
 
+QAbstractListModel*
+Config::optionList()
+{
+    if ( !m_optionList )
+    {
+        m_optionList = new OptionListModel( m_model, this );
+    }
+    return m_optionList;
+}
+
 QString
 Config::sidebarLabel() const
 {
@@ -84,6 +102,7 @@ Config::titleLabel() const
 void
 Config::loadGroupList( const QVariantList& groupData )
 {
+    m_groupData = groupData;
     m_model->setupModelData( groupData );
     if ( m_model->rowCount() < 1 )
     {
@@ -94,6 +113,56 @@ Config::loadGroupList( const QVariantList& groupData )
     {
         setStatus( Status::Ok );
     }
+    compilePresets();
+}
+
+void
+Config::compilePresets()
+{
+    m_presets.clear();
+    for ( const auto& v : m_presetData )
+    {
+        const auto map = v.toMap();
+        Preset preset { Calamares::Locale::TranslatedString( map, "name", "OptionsViewStep" ),
+                        SelectionMask( m_model->leafCount() ) };
+        if ( preset.name.isEmpty() )
+        {
+            cWarning() << "Options preset without a *name* is ignored.";
+            continue;
+        }
+        for ( const auto& option : Calamares::getStringList( map, "options" ) )
+        {
+            const int leaf = m_model->findLeaf( option );
+            if ( leaf < 0 )
+            {
+                cWarning() << "Options preset" << preset.name.get() << "names unknown option" << option;
+                continue;
+            }
+            preset.mask.set( leaf );
+        }
+        m_presets.append( preset );
+    }
+    emit presetsChanged();
+}
+
+QStringList
+Config::presetNames() const
+{
+    QStringList names;
+    for ( const auto& preset : m_presets )
+    {
+        names.append( preset.name.get() );
+    }
+    return names;
+}
+
+void
+Config::applyPreset( int index )
+{
+    if ( 0 <= index && index < m_presets.count() )
+    {
+        m_model->applySelectionMask( m_presets.at( index ).mask );
+    }
 }
 
 void
@@ -104,9 +173,173 @@ Config::loadingDone()
         m_queue->deleteLater();
         m_queue = nullptr;
     }
+    applyPreseed();
+    if ( m_headless )
+    {
+        // Nobody will change the selection, so store it right away
+        finalizeGlobalStorage();
+    }
+    else if ( !m_restored && m_preseedFile.isEmpty() && m_preseedKey.isEmpty() )
+    {
+        startProbes();
+    }
     emit statusReady();
 }
 
+void
+Config::startProbes()
+{
+    const auto probes = m_model->leafProbes();
+    if ( probes.isEmpty() )
+    {
+        return;
+    }
+
+    const int leafCount = m_model->leafCount();
+    auto cache = OptionProbe::loadCache();
+    SelectionMask found( leafCount );
+    QVector< QPair< int, QVariantMap > > pending;
+    for ( const auto& probe : probes )
+    {
+        const QString key = OptionProbe::key( probe.second );
+        if ( cache.contains( key ) )
+        {
+            found.set( probe.first, cache.value( key ) );
+        }
+        else
+        {
+            pending.append( probe );
+        }
+    }
+
+    auto apply = [ this, leafCount ]( const SelectionMask& hits )
+    {
+        if ( m_model->leafCount() != leafCount )
+        {
+            return;  // The groups were reloaded meanwhile
+        }
+        m_model->applyProbeHits( hits );
+    };
+    cDebug() << "Options probes:" << probes.count() - pending.count() << "cached," << pending.count() << "to run.";
+    if ( pending.isEmpty() )
+    {
+        apply( found );
+        return;
+    }
+
+    QVector< QVariantMap > specs;
+    for ( const auto& probe : std::as_const( pending ) )
+    {
+        specs.append( probe.second );
+    }
+    auto* watcher = new QFutureWatcher< bool >( this );
+    connect( watcher,
+             &QFutureWatcher< bool >::finished,
+             this,
+             [ = ]() mutable
+             {
+                 for ( int i = 0; i < pending.count(); ++i )
+                 {
+                     const bool holds = watcher->resultAt( i );
+                     cache.insert( OptionProbe::key( pending.at( i ).second ), holds );
+                     found.set( pending.at( i ).first, holds );
+                 }
+                 OptionProbe::saveCache( cache );
+                 apply( found );
+                 watcher->deleteLater();
+             } );
+    watcher->setFuture( QtConcurrent::mapped( specs, &OptionProbe::evaluate ) );
+}
+
+QVector< QPair< int, QString > >
+Config::preseedOptions() const
+{
+    QStringList unknown;
+    QStringList names;
+    QVector< QPair< int, QString > > options;
+    if ( !m_preseedKey.isEmpty() )
+    {
+        auto* gs = Calamares::JobQueue::instance() ? Calamares::JobQueue::instance()->globalStorage() : nullptr;
+        if ( gs && gs->contains( m_preseedKey ) )
+        {
+            // Either a list of names, or a space-separated string like
+            // the *options* value written by finalizeGlobalStorage(),
+            // which is read back by whole operations
+            const QVariant value = gs->value( m_preseedKey );
+            if ( Calamares::typeOf( value ) == Calamares::ListVariantType )
+            {
+                names = value.toStringList();
+            }
+            else
+            {
+                options = m_model->findOperations( value.toString(), &unknown );
+            }
+        }
+    }
+    if ( names.isEmpty() && options.isEmpty() && !m_preseedFile.isEmpty() )
+    {
+        QFile file( m_preseedFile );
+        if ( file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+        {
+            while ( !file.atEnd() )
+            {
+                const QString line = QString::fromUtf8( file.readLine() ).trimmed();
+                if ( !line.isEmpty() && !line.startsWith( '#' ) )
+                {
+                    names.append( line );
+                }
+            }
+        }
+        else
+        {
+            cWarning() << "Could not read options preseed" << m_preseedFile;
+        }
+    }
+
+    // A name is an option's name or whole operation, or else operations
+    for ( const auto& name : std::as_const( names ) )
+    {
+        const int leaf = m_model->findLeaf( name );
+        if ( leaf >= 0 )
+        {
+            options.append( { leaf, QString() } );
+        }
+        else
+        {
+            options += m_model->findOperations( name, &unknown );
+        }
+    }
+    for ( const auto& name : std::as_const( unknown ) )
+    {
+        cWarning() << "Options preseed names unknown option" << name;
+    }
+    return options;
+}
+
+void
+Config::applyPreseed()
+{
+    if ( m_preseedFile.isEmpty() && m_preseedKey.isEmpty() )
+    {
+        return;
+    }
+
+    SelectionMask mask( m_model->leafCount() );
+    QHash< int, QString > inputs;
+    const auto options = preseedOptions();
+    for ( const auto& [ leaf, input ] : options )
+    {
+        mask.set( leaf );
+        if ( !input.isEmpty() )
+        {
+            inputs.insert( leaf, input );
+        }
+    }
+    cDebug() << "Options preseed selects" << options.count() << "options.";
+    m_model->applySelectionMask( mask );
+    m_model->setLeafInputs( inputs );
+}
+
 void
 Config::setConfigurationMap( const QVariantMap& configurationMap )
 {
@@ -129,20 +362,41 @@ Config::setConfigurationMap( const QVariantMap& configurationMap )
         m_titleLabel = new Calamares::Locale::TranslatedString( label, "title", className );
     }
 
+    m_presetData = configurationMap.value( "presets" ).toList();
+
+    auto preseed = Calamares::getSubMap( configurationMap, "preseed", bogus );
+    m_preseedFile = Calamares::getString( preseed, "file" );
+    m_preseedKey = Calamares::getString( preseed, "globalStorageKey" );
+    m_headless = Calamares::getBool( preseed, "headless", false );
+    if ( m_headless && m_preseedFile.isEmpty() && m_preseedKey.isEmpty() )
+    {
+        cWarning() << "Options *preseed.headless* is set without a *file* or *globalStorageKey*.";
+    }
+
     // Lastly, load the groups data
     const QString key = QStringLiteral( "groupsUrl" );
     const auto& groupsUrlVariant = configurationMap.value( key );
-    m_queue = new LoaderQueue( this );
+    m_sources.clear();
     if ( Calamares::typeOf( groupsUrlVariant ) == Calamares::StringVariantType )
     {
-        m_queue->append( SourceItem::makeSourceItem( groupsUrlVariant.toString(), configurationMap ) );
+        m_sources.append( groupsUrlVariant.toString() );
     }
     else if ( Calamares::typeOf( groupsUrlVariant ) == Calamares::ListVariantType )
     {
-        for ( const auto& s : groupsUrlVariant.toStringList() )
-        {
-            m_queue->append( SourceItem::makeSourceItem( s, configurationMap ) );
-        }
+        m_sources = groupsUrlVariant.toStringList();
+    }
+    m_sourcesChecksum = OptionsSnapshot::checksum( m_sources, configurationMap.value( "groups" ).toList() );
+    if ( restoreSnapshot() )
+    {
+        // Still finish asynchronously, like a fresh load
+        QMetaObject::invokeMethod( this, "loadingDone", Qt::QueuedConnection );
+        return;
+    }
+
+    m_queue = new LoaderQueue( this );
+    for ( const auto& s : std::as_const( m_sources ) )
+    {
+        m_queue->append( SourceItem::makeSourceItem( s, configurationMap ) );
     }
 
     setStatus( required() ? Status::FailedNoData : Status::Ok );
@@ -151,6 +405,42 @@ Config::setConfigurationMap( const QVariantMap& configurationMap )
     m_queue->load();
 }
 
+bool
+Config::restoreSnapshot()
+{
+    const auto snapshot = OptionsSnapshot::load( OptionsSnapshot::path( m_sources ), m_sourcesChecksum );
+    if ( !snapshot.isValid() )
+    {
+        return false;
+    }
+
+    m_restored = true;
+    loadGroupList( snapshot.groups );
+    if ( statusCode() != Status::Ok || m_model->leafCount() != snapshot.selection.size() )
+    {
+        cWarning() << "Options snapshot does not match its groups, loading again.";
+        m_model->setupModelData( QVariantList() );
+        m_groupData.clear();
+        m_restored = false;
+        return false;
+    }
+    m_model->applySelectionMask( snapshot.selection );
+    m_model->setLeafInputs( snapshot.inputs );
+    cDebug() << "Options restored from snapshot," << m_model->leafCount() << "options.";
+    return true;
+}
+
+void
+Config::saveSnapshot()
+{
+    if ( m_sourcesChecksum.isEmpty() || m_groupData.isEmpty() || statusCode() != Status::Ok )
+    {
+        return;
+    }
+    OptionsSnapshot snapshot { m_sourcesChecksum, m_groupData, m_model->selectionMask(), m_model->leafInputs() };
+    snapshot.save( OptionsSnapshot::path( m_sources ) );
+}
+
 void
 Config::finalizeGlobalStorage()
 {
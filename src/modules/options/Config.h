@@ -17,24 +17,30 @@
 #include "locale/TranslatableConfiguration.h"
 #include "modulesystem/InstanceKey.h"
 
+#include <QAbstractListModel>
 #include <QObject>
 #include <QVariantMap>
 
 #include <memory>
 
 class LoaderQueue;
+class OptionListModel;
 
 class Config : public QObject
 {
     Q_OBJECT
 
     Q_PROPERTY( OptionModel* optionModel MEMBER m_model FINAL )
+    Q_PROPERTY( QAbstractListModel* optionList READ optionList CONSTANT FINAL )
     Q_PROPERTY( QString status READ status NOTIFY statusChanged FINAL )
 
     // Translations, of the module name (for sidebar) and above the list
     Q_PROPERTY( QString sidebarLabel READ sidebarLabel NOTIFY sidebarLabelChanged FINAL )
     Q_PROPERTY( QString titleLabel READ titleLabel NOTIFY titleLabelChanged FINAL )
 
+    // Names of the selection presets, in configuration order
+    Q_PROPERTY( QStringList presetNames READ presetNames NOTIFY presetsChanged FINAL )
+
 public:
     Config( QObject* parent = nullptr );
     ~Config() override;
@@ -60,7 +66,20 @@ public:
     bool required() const { return m_required; }
     void setRequired( bool r ) { m_required = r; }
 
+    /** @brief Is the selection preseeded, without user interaction?
+     *
+     * Set by *preseed.headless* in the configuration. A headless
+     * step creates no widgets; the preseed is applied as soon as the
+     * groups are loaded.
+     */
+    bool isHeadless() const { return m_headless; }
+
     OptionModel* model() const { return m_model; }
+    /** @brief Flattened, list-shaped view of the model for QML
+     *
+     * Created on first use, so the widget page does not pay for it.
+     */
+    QAbstractListModel* optionList();
 
     QString sidebarLabel() const;
     QString titleLabel() const;
@@ -72,6 +91,14 @@ public:
      */
     void loadGroupList( const QVariantList& groupData );
 
+    QStringList presetNames() const;
+    /** @brief Selects exactly the options of preset @p index
+     *
+     * Presets are compiled to a selection mask when the groups are
+     * loaded, so this is a single OptionModel::applySelectionMask().
+     */
+    Q_INVOKABLE void applyPreset( int index );
+
     /** @brief Write the selected option lists to global storage
      *
      * Since the config doesn't know what module it is for,
@@ -79,23 +106,63 @@ public:
      */
     void finalizeGlobalStorage();
 
+    /** @brief Saves the loaded groups and the selection for a relaunch
+     *
+     * The snapshot is restored by setConfigurationMap() instead of
+     * loading the groups again, as long as the sources are unchanged
+     * and the system has not been rebooted. See OptionsSnapshot.
+     */
+    void saveSnapshot();
+
 Q_SIGNALS:
     void statusChanged( QString status );  ///< Something changed
     void sidebarLabelChanged( QString label );
     void titleLabelChanged( QString label );
     void statusReady();  ///< Loading groups is complete
+    void presetsChanged();
 
 private Q_SLOTS:
     void retranslate();
     void loadingDone();
 
 private:
+    /// @brief Compiles the *presets* from the configuration against the current model
+    void compilePresets();
+    /// @brief The options listed by the *preseed* file or GlobalStorage key, as (leaf number, input) pairs
+    QVector< QPair< int, QString > > preseedOptions() const;
+    /// @brief Selects exactly the preseeded options, if there is a preseed
+    void applyPreseed();
+    /// @brief Loads groups and selection from a snapshot, if there is a valid one
+    bool restoreSnapshot();
+    /** @brief Evaluates the *probe* of options in the background
+     *
+     * Results are cached per boot. Options whose probe holds are
+     * added to the selection in one batch when all probes are done.
+     */
+    void startProbes();
+
+    struct Preset
+    {
+        Calamares::Locale::TranslatedString name;
+        SelectionMask mask;
+    };
+
     Calamares::Locale::TranslatedString* m_sidebarLabel = nullptr;  // As it appears in the sidebar
     Calamares::Locale::TranslatedString* m_titleLabel = nullptr;
     OptionModel* m_model = nullptr;
+    OptionListModel* m_optionList = nullptr;
     LoaderQueue* m_queue = nullptr;
     Status m_status = Status::Ok;
     bool m_required = false;
+    bool m_headless = false;
+    QString m_preseedFile;  ///< *preseed.file*, one option per line
+    QString m_preseedKey;  ///< *preseed.globalStorageKey*
+    QStringList m_sources;  ///< *groupsUrl*, in order
+    QByteArray m_sourcesChecksum;  ///< Empty if the sources cannot be snapshotted
+    QVariantList m_groupData;  ///< As last passed to loadGroupList()
+    bool m_restored = false;  ///< The selection came from a snapshot
+    QVariantList m_presetData;  ///< *presets* from the configuration
+    QVector< Preset > m_presets;
 };
 
 #endif
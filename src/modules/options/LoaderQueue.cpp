@@ -12,6 +12,7 @@
 #include "LoaderQueue.h"
 
 #include "Config.h"
+#include "OptionsSchema.h"
 #include "network/Manager.h"
 #include "utils/Logger.h"
 #include "utils/RAII.h"
@@ -179,22 +180,21 @@ LoaderQueue::dataArrived()
     QByteArray yamlData = m_reply->readAll();
     try
     {
-        auto groups = ::YAML::Load( yamlData.constData() );
+        auto document = ::YAML::Load( yamlData.constData() );
 
-        if ( groups.IsSequence() )
+        // Invalid data never reaches the model; the next source is tried instead.
+        QVariantList groups;
+        OptionsSchema::Error error;
+        if ( OptionsSchema::parseGroups( document, groups, error ) )
         {
-            m_config->loadGroupList( Calamares::YAML::sequenceToVariant( groups ) );
-            next.done( m_config->statusCode() == Config::Status::Ok );
-        }
-        else if ( groups.IsMap() )
-        {
-            auto map = Calamares::YAML::mapToVariant( groups );
-            m_config->loadGroupList( map.value( "groups" ).toList() );
+            m_config->loadGroupList( groups );
             next.done( m_config->statusCode() == Config::Status::Ok );
         }
         else
         {
-            cWarning() << "Options groups data does not form a sequence.";
+            cWarning() << "Options groups data from" << m_reply->url() << "is invalid at line" << error.line
+                       << "column" << error.column << ':' << error.message;
+            m_config->setStatus( Config::Status::FailedBadData );
         }
     }
     catch ( ::YAML::Exception& e )
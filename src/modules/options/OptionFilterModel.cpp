@@ -0,0 +1,63 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "OptionFilterModel.h"
+
+#include "OptionModel.h"
+
+OptionFilterModel::OptionFilterModel( OptionModel* source, QObject* parent )
+    : QSortFilterProxyModel( parent )
+    , m_source( source )
+{
+    setRecursiveFilteringEnabled( true );
+    setDynamicSortFilter( false );
+    setSourceModel( source );
+    // The index is rebuilt when the model is reset; re-run the query
+    connect( source, &QAbstractItemModel::modelReset, this, &OptionFilterModel::refreshMatches );
+}
+
+void
+OptionFilterModel::setFilterString( const QString& filter )
+{
+    const QString trimmed = filter.trimmed();
+    if ( trimmed == m_filter )
+    {
+        return;
+    }
+    m_filter = trimmed;
+    refreshMatches();
+}
+
+void
+OptionFilterModel::refreshMatches()
+{
+    m_matches = m_filter.isEmpty() ? QBitArray() : m_source->searchIndex().match( m_filter );
+    invalidateFilter();
+}
+
+bool
+OptionFilterModel::filterAcceptsRow( int sourceRow, const QModelIndex& sourceParent ) const
+{
+    if ( m_filter.isEmpty() )
+    {
+        return true;
+    }
+
+    // Rows are accepted if they, or an ancestor, match. Ancestors of
+    // a match are accepted by recursive filtering.
+    for ( QModelIndex index = m_source->index( sourceRow, 0, sourceParent ); index.isValid(); index = index.parent() )
+    {
+        const int serial = m_source->itemSerial( index );
+        if ( 0 <= serial && serial < m_matches.size() && m_matches.testBit( serial ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,54 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef OPTIONS_OPTIONFILTERMODEL_H
+#define OPTIONS_OPTIONFILTERMODEL_H
+
+#include <QBitArray>
+#include <QSortFilterProxyModel>
+
+class OptionModel;
+
+/** @brief Filters the option tree by a search string
+ *
+ * Matching is done by the search index of the OptionModel, once per
+ * change of the filter string; filterAcceptsRow() is then a bit lookup.
+ * A row is accepted when it matches, or when one of its ancestors
+ * matches (so a matching group shows its options). Recursive filtering
+ * keeps the ancestors of matching rows visible.
+ *
+ * Check-state changes are passed through to the source model, so
+ * checking a (filtered) group still checks all of its options,
+ * including the ones that are currently filtered out.
+ */
+class OptionFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit OptionFilterModel( OptionModel* source, QObject* parent = nullptr );
+
+    QString filterString() const { return m_filter; }
+    bool isFiltering() const { return !m_filter.isEmpty(); }
+
+public Q_SLOTS:
+    void setFilterString( const QString& filter );
+
+protected:
+    bool filterAcceptsRow( int sourceRow, const QModelIndex& sourceParent ) const override;
+
+private:
+    void refreshMatches();
+
+    OptionModel* m_source = nullptr;
+    QString m_filter;
+    QBitArray m_matches;
+};
+
+#endif
@@ -0,0 +1,211 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "OptionListModel.h"
+
+#include "OptionModel.h"
+
+#include <algorithm>
+
+OptionListModel::OptionListModel( OptionModel* source, QObject* parent )
+    : QAbstractListModel( parent )
+    , m_source( source )
+{
+    connect( source, &QAbstractItemModel::modelReset, this, &OptionListModel::rebuild );
+    connect( source, &QAbstractItemModel::dataChanged, this, &OptionListModel::sourceDataChanged );
+    rebuild();
+}
+
+int
+OptionListModel::serial( const QModelIndex& sourceIndex ) const
+{
+    return m_source->itemSerial( sourceIndex );
+}
+
+bool
+OptionListModel::isExpanded( const QModelIndex& sourceIndex ) const
+{
+    return m_expanded.contains( serial( sourceIndex ) );
+}
+
+void
+OptionListModel::collectVisible( const QModelIndex& parent, int depth, QVector< Row >& rows ) const
+{
+    const int count = m_source->rowCount( parent );
+    for ( int i = 0; i < count; ++i )
+    {
+        const QModelIndex child = m_source->index( i, OptionModel::NameColumn, parent );
+        rows.append( Row { child, depth } );
+        if ( isExpanded( child ) )
+        {
+            collectVisible( child, depth + 1, rows );
+        }
+    }
+}
+
+void
+OptionListModel::rebuild()
+{
+    beginResetModel();
+    m_expanded.clear();
+    for ( const auto& index : m_source->startExpandedIndexes() )
+    {
+        m_expanded.insert( serial( index ) );
+    }
+    m_rows.clear();
+    collectVisible( QModelIndex(), 0, m_rows );
+    endResetModel();
+}
+
+void
+OptionListModel::sourceDataChanged( const QModelIndex&, const QModelIndex&, const QVector< int >& roles )
+{
+    // A change in selection ripples through a subtree, and finding the
+    // affected rows costs more than letting the ListView refresh the
+    // handful of delegates it has instantiated.
+    if ( !m_rows.isEmpty() )
+    {
+        QVector< int > listRoles;
+        for ( int role : roles )
+        {
+            if ( role == Qt::CheckStateRole )
+            {
+                listRoles << CheckStateRole;
+            }
+            else if ( role == Qt::DisplayRole || role == Qt::EditRole )
+            {
+                listRoles << InputRole << NameRole << DescriptionRole;
+            }
+        }
+        emit dataChanged( index( 0 ), index( m_rows.count() - 1 ), listRoles );
+    }
+}
+
+int
+OptionListModel::rowCount( const QModelIndex& parent ) const
+{
+    return parent.isValid() ? 0 : m_rows.count();
+}
+
+QVariant
+OptionListModel::data( const QModelIndex& index, int role ) const
+{
+    if ( !index.isValid() || index.row() >= m_rows.count() )
+    {
+        return QVariant();
+    }
+
+    const Row& row = m_rows.at( index.row() );
+    switch ( role )
+    {
+    case Qt::DisplayRole:
+    case NameRole:
+        return row.index.data( Qt::DisplayRole );
+    case DescriptionRole:
+        return row.index.sibling( row.index.row(), OptionModel::DescriptionColumn ).data( Qt::DisplayRole );
+    case InputRole:
+        return row.index.sibling( row.index.row(), OptionModel::InputColumn ).data( Qt::DisplayRole );
+    case DepthRole:
+        return row.depth;
+    case HasChildrenRole:
+        return m_source->rowCount( row.index ) > 0;
+    case ExpandedRole:
+        return isExpanded( row.index );
+    case CheckStateRole:
+    {
+        const QVariant state = row.index.data( Qt::CheckStateRole );
+        return state.isValid() ? state.toInt() : int( Qt::Unchecked );
+    }
+    case CheckableRole:
+        return bool( m_source->flags( row.index ) & Qt::ItemIsUserCheckable );
+    case EditableRole:
+        return bool( m_source->flags( row.index.sibling( row.index.row(), OptionModel::InputColumn ) )
+                     & Qt::ItemIsEditable );
+    case SpacerRole:
+        return row.index.data( OptionModel::SpacerRole );
+    default:
+        return QVariant();
+    }
+}
+
+QHash< int, QByteArray >
+OptionListModel::roleNames() const
+{
+    return { { NameRole, "name" },
+             { DescriptionRole, "description" },
+             { InputRole, "input" },
+             { DepthRole, "depth" },
+             { HasChildrenRole, "hasChildren" },
+             { ExpandedRole, "expanded" },
+             { CheckStateRole, "checkState" },
+             { CheckableRole, "checkable" },
+             { EditableRole, "editable" },
+             { SpacerRole, "spacer" } };
+}
+
+void
+OptionListModel::toggleExpanded( int row )
+{
+    if ( row < 0 || row >= m_rows.count() || m_source->rowCount( m_rows.at( row ).index ) < 1 )
+    {
+        return;
+    }
+
+    const Row current = m_rows.at( row );
+    const int s = serial( current.index );
+    if ( m_expanded.contains( s ) )
+    {
+        // Visible descendants are the rows right below that are deeper
+        int last = row;
+        while ( last + 1 < m_rows.count() && m_rows.at( last + 1 ).depth > current.depth )
+        {
+            ++last;
+        }
+        m_expanded.remove( s );
+        if ( last > row )
+        {
+            beginRemoveRows( QModelIndex(), row + 1, last );
+            m_rows.remove( row + 1, last - row );
+            endRemoveRows();
+        }
+    }
+    else
+    {
+        m_expanded.insert( s );
+        QVector< Row > children;
+        collectVisible( current.index, current.depth + 1, children );
+        if ( !children.isEmpty() )
+        {
+            beginInsertRows( QModelIndex(), row + 1, row + children.count() );
+            m_rows.insert( row + 1, children.count(), Row() );
+            std::copy( children.cbegin(), children.cend(), m_rows.begin() + row + 1 );
+            endInsertRows();
+        }
+    }
+    emit dataChanged( index( row ), index( row ), { ExpandedRole } );
+}
+
+void
+OptionListModel::setCheckState( int row, int state )
+{
+    if ( 0 <= row && row < m_rows.count() )
+    {
+        m_source->setData( m_rows.at( row ).index, state, Qt::CheckStateRole );
+    }
+}
+
+void
+OptionListModel::setInput( int row, const QString& input )
+{
+    if ( 0 <= row && row < m_rows.count() )
+    {
+        const QModelIndex& i = m_rows.at( row ).index;
+        m_source->setData( i.sibling( i.row(), OptionModel::InputColumn ), input, Qt::EditRole );
+    }
+}
@@ -0,0 +1,80 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef OPTIONS_OPTIONLISTMODEL_H
+#define OPTIONS_OPTIONLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QSet>
+#include <QVector>
+
+class OptionModel;
+
+/** @brief Flat, list-shaped view of the visible rows of an OptionModel
+ *
+ * QML ListView can only show lists; this model exposes the rows of
+ * the option tree that are visible given the expanded state of each
+ * group, with the depth as a role for indentation. Expanding or
+ * collapsing a group inserts or removes just that group's visible
+ * descendants, so a ListView only instantiates delegates for the
+ * rows that are on screen.
+ *
+ * Selection and input are passed to the tree model, which keeps the
+ * tri-state semantics of groups.
+ */
+class OptionListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles : int
+    {
+        NameRole = Qt::UserRole + 1,
+        DescriptionRole,
+        InputRole,
+        DepthRole,
+        HasChildrenRole,
+        ExpandedRole,
+        CheckStateRole,
+        CheckableRole,
+        EditableRole,
+        SpacerRole
+    };
+
+    explicit OptionListModel( OptionModel* source, QObject* parent = nullptr );
+
+    int rowCount( const QModelIndex& parent = QModelIndex() ) const override;
+    QVariant data( const QModelIndex& index, int role ) const override;
+    QHash< int, QByteArray > roleNames() const override;
+
+    Q_INVOKABLE void toggleExpanded( int row );
+    Q_INVOKABLE void setCheckState( int row, int state );
+    Q_INVOKABLE void setInput( int row, const QString& input );
+
+private:
+    struct Row
+    {
+        QModelIndex index;  ///< Column 0 of the source model
+        int depth = 0;
+    };
+
+    void rebuild();
+    void sourceDataChanged( const QModelIndex&, const QModelIndex&, const QVector< int >& roles );
+    /// @brief Appends the visible rows below @p parent to @p rows
+    void collectVisible( const QModelIndex& parent, int depth, QVector< Row >& rows ) const;
+
+    bool isExpanded( const QModelIndex& sourceIndex ) const;
+    int serial( const QModelIndex& sourceIndex ) const;
+
+    OptionModel* m_source = nullptr;
+    QVector< Row > m_rows;  ///< Source rows are only replaced by a model reset
+    QSet< int > m_expanded;  ///< Serials of expanded groups
+};
+
+#endif
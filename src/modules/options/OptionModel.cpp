@@ -22,6 +22,8 @@
 #include <string_view>
 #include <utility>
 
+#include <QBitArray>
+#include <QRegularExpression>
 #include <QMessageBox>
 
 static bool gShowConfError {};
@@ -41,6 +43,18 @@ setSelections( const QStringList& selectNames, OptionTreeItem* item )
     }
 }
 
+/// @brief How deep @p item is below @p root; top-level rows have depth 0
+static int
+itemDepth( const OptionTreeItem* item, const OptionTreeItem* root )
+{
+    int depth = 0;
+    for ( const OptionTreeItem* p = item->parentItem(); p && p != root; p = p->parentItem() )
+    {
+        ++depth;
+    }
+    return depth;
+}
+
 /** @brief Collects all the "source" values from @p groupList
  *
  * Iterates over @p groupList and returns all nonempty "source"
@@ -200,9 +214,20 @@ OptionModel::data( const QModelIndex& index, int role ) const
     case Qt::CheckStateRole:
         return index.column() == NameColumn ? ( item->isImmutable() ? QVariant() : item->isSelected() ) : QVariant();
     case Qt::DisplayRole:
+        if ( m_strings && index.column() != InputColumn )
+        {
+            const auto& strings = index.column() == NameColumn ? m_strings->names : m_strings->descriptions;
+            const QString& s = strings.at( item->serial() );
+            if ( !s.isNull() )
+            {
+                return s;
+            }
+        }
         return item->data( index.column() );
     case MetaExpandRole:
         return item->expandOnStart();
+    case SpacerRole:
+        return item->isSpacer();
     case Qt::EditRole:
         return item->isEditable() ? item->data( index.column() ) : QVariant();
     default:
@@ -222,11 +247,27 @@ OptionModel::setData( const QModelIndex& index, const QVariant& value, int role
     {
         OptionTreeItem* item = static_cast< OptionTreeItem* >( index.internalPointer() );
         const auto checkedStateInfo = static_cast< Qt::CheckState >( value.toInt() );
+        const SelectionMask before = selectionMask();
         item->setSelected( checkedStateInfo );
 
-        emit dataChanged( this->index( 0, 0 ),
-                          index.sibling( index.column(), index.row() + 1 ),
-                          QVector< int >( Qt::CheckStateRole ) );
+        // Whatever this changed is the user's choice, which probes leave alone
+        const SelectionMask after = selectionMask();
+        for ( int w = 0; w < after.wordCount() && w < m_touched.wordCount(); ++w )
+        {
+            m_touched.word( w ) |= before.word( w ) ^ after.word( w );
+        }
+
+        // Selection ripples down to the children and up to the ancestors
+        // (and sideways in distinct groups), so announce the whole
+        // top-level subtree that contains the item.
+        QModelIndex top = index.sibling( index.row(), NameColumn );
+        while ( top.parent().isValid() )
+        {
+            top = top.parent();
+        }
+        const QVector< int > roles { Qt::CheckStateRole };
+        emit dataChanged( top, top, roles );
+        emitChildrenChanged( top, roles );
     }
     else if ( role == Qt::EditRole && index.isValid() )
     {
@@ -238,14 +279,366 @@ OptionModel::setData( const QModelIndex& index, const QVariant& value, int role
 
         const auto inputString = static_cast< QString >( value.toString() );
         item->setInput( inputString );
+        noteWidthHint( InputColumn, inputString, itemDepth( item, m_rootItem ), item->serial() );
+        emit headerDataChanged( Qt::Horizontal, InputColumn, InputColumn );
 
-        emit dataChanged(
-            this->index( 0, 0 ), index.sibling( index.column(), index.row() + 1 ), QVector< int >( Qt::EditRole ) );
+        emit dataChanged( index, index, QVector< int > { Qt::DisplayRole, Qt::EditRole } );
         return true;
     }
     return true;
 }
 
+void
+OptionModel::emitChildrenChanged( const QModelIndex& parent,
+                                  const QVector< int >& roles,
+                                  int firstColumn,
+                                  int lastColumn )
+{
+    const int rows = rowCount( parent );
+    if ( rows < 1 )
+    {
+        return;
+    }
+    emit dataChanged( index( 0, firstColumn, parent ), index( rows - 1, lastColumn, parent ), roles );
+    for ( int i = 0; i < rows; ++i )
+    {
+        emitChildrenChanged( index( i, NameColumn, parent ), roles, firstColumn, lastColumn );
+    }
+}
+
+QModelIndexList
+OptionModel::startExpandedIndexes() const
+{
+    QModelIndexList indexes;
+    indexes.reserve( m_startExpanded.count() );
+    for ( const auto& [ item, row ] : m_startExpanded )
+    {
+        indexes.append( createIndex( row, NameColumn, item ) );
+    }
+    return indexes;
+}
+
+SelectionMask
+OptionModel::selectionMask() const
+{
+    SelectionMask mask( m_leaves.count() );
+    for ( int leaf = 0; leaf < m_leaves.count(); ++leaf )
+    {
+        if ( m_leaves.at( leaf )->isSelected() != Qt::Unchecked )
+        {
+            mask.set( leaf );
+        }
+    }
+    return mask;
+}
+
+void
+OptionModel::applySelectionMask( const SelectionMask& mask )
+{
+    if ( !m_rootItem || mask.size() != m_leaves.count() )
+    {
+        cWarning() << "Selection mask of size" << mask.size() << "does not fit" << m_leaves.count() << "options.";
+        return;
+    }
+
+    const SelectionMask current = selectionMask();
+    QBitArray dirty( m_items.count() );  // Groups to recount, by serial
+    bool changed = false;
+    for ( int w = 0; w < mask.wordCount(); ++w )
+    {
+        for ( auto diff = current.word( w ) ^ mask.word( w ); diff; diff &= diff - 1 )
+        {
+            const int leaf = w * SelectionMask::wordBits + int( qCountTrailingZeroBits( diff ) );
+            OptionTreeItem* item = m_leaves.at( leaf );
+            if ( item->isImmutable() )
+            {
+                continue;
+            }
+            item->setSelectedState( mask.test( leaf ) ? Qt::Checked : Qt::Unchecked );
+            dirty.setBit( item->parentItem()->serial() );
+            changed = true;
+        }
+    }
+    if ( !changed )
+    {
+        return;
+    }
+
+    // Reverse pre-order visits all children before their parent,
+    // so every group is recounted once, after its children.
+    for ( int serial = m_items.count() - 1; serial > 0; --serial )
+    {
+        if ( !dirty.testBit( serial ) )
+        {
+            continue;
+        }
+        OptionTreeItem* group = m_items.at( serial );
+        if ( group->isDistinct() )
+        {
+            // Like a radio button, keep only the first selected child
+            bool seen = false;
+            for ( int i = 0; i < group->childCount(); ++i )
+            {
+                OptionTreeItem* child = group->child( i );
+                if ( child->isSelected() != Qt::Unchecked )
+                {
+                    if ( seen )
+                    {
+                        child->setSelectedState( Qt::Unchecked );
+                        child->setChildrenSelected( Qt::Unchecked );
+                    }
+                    seen = true;
+                }
+            }
+        }
+        group->setSelectedState( group->selectionFromChildren() );
+        dirty.setBit( group->parentItem()->serial() );
+    }
+
+    emitChildrenChanged( QModelIndex(), QVector< int > { Qt::CheckStateRole } );
+}
+
+QVector< QPair< int, QString > >
+OptionModel::findOperations( const QString& text, QStringList* unknown ) const
+{
+    QVector< QPair< int, QString > > found;
+    int pos = 0;
+    while ( pos < text.size() )
+    {
+        if ( text.at( pos ) == ' ' )
+        {
+            ++pos;
+            continue;
+        }
+
+        // Where each of the next words ends, for the longest operation first
+        QVector< int > ends;
+        for ( int end = pos; ends.count() < m_operationWords && end < text.size(); )
+        {
+            const int space = text.indexOf( ' ', end );
+            end = space < 0 ? int( text.size() ) : space;
+            ends.append( end );
+            ++end;
+        }
+
+        int best = -1;
+        int bestLength = 0;
+        for ( int k = ends.count() - 1; k >= 0 && best < 0; --k )
+        {
+            // A fixed operation ends at a space; an editable one goes on with its input
+            const int end = ends.at( k );
+            const int fixed = m_leafByOperation.value( text.mid( pos, end - pos ), -1 );
+            if ( fixed >= 0 && !m_leaves.at( fixed )->isEditable() )
+            {
+                best = fixed;
+                bestLength = end - pos;
+                break;
+            }
+            const int equals = text.indexOf( '=', k > 0 ? ends.at( k - 1 ) + 1 : pos );
+            const int editable
+                = equals >= 0 && equals < end ? m_leafByOperation.value( text.mid( pos, equals + 1 - pos ), -1 ) : -1;
+            if ( editable >= 0 && m_leaves.at( editable )->isEditable() )
+            {
+                best = editable;
+                bestLength = equals + 1 - pos;
+            }
+            else if ( fixed >= 0 )
+            {
+                // An editable option that has no "=" in its operation
+                best = fixed;
+                bestLength = end - pos;
+            }
+        }
+
+        if ( best < 0 )
+        {
+            const int space = text.indexOf( ' ', pos );
+            const int end = space < 0 ? int( text.size() ) : space;
+            const QString word = text.mid( pos, end - pos );
+            const int leaf = findLeaf( word );
+            if ( leaf >= 0 )
+            {
+                found.append( { leaf, QString() } );
+            }
+            else if ( unknown )
+            {
+                unknown->append( word );
+            }
+            pos = end;
+        }
+        else if ( m_leaves.at( best )->isEditable() )
+        {
+            const int start = pos + bestLength;
+            const int space = text.indexOf( ' ', start );
+            const int end = space < 0 ? int( text.size() ) : space;
+            found.append( { best, text.mid( start, end - start ) } );
+            pos = end;
+        }
+        else
+        {
+            found.append( { best, QString() } );
+            pos += bestLength;
+        }
+    }
+    return found;
+}
+
+void
+OptionModel::collectLeaves( const OptionTreeItem* item, QVector< int >& leaves ) const
+{
+    const int leaf = m_leafBySerial.value( item->serial(), -1 );
+    if ( leaf >= 0 )
+    {
+        leaves.append( leaf );
+    }
+    for ( int i = 0; i < item->childCount(); ++i )
+    {
+        collectLeaves( item->child( i ), leaves );
+    }
+}
+
+void
+OptionModel::applyProbeHits( const SelectionMask& hits )
+{
+    if ( !m_rootItem || hits.size() != m_leaves.count() )
+    {
+        cWarning() << "Probe results of size" << hits.size() << "do not fit" << m_leaves.count() << "options.";
+        return;
+    }
+
+    SelectionMask mask = selectionMask();
+    SelectionMask kept( m_leaves.count() );  ///< Selected by a hit, or by the user
+    for ( int leaf = 0; leaf < m_leaves.count(); ++leaf )
+    {
+        if ( !hits.test( leaf ) || m_touched.test( leaf ) )
+        {
+            continue;
+        }
+        if ( mask.test( leaf ) )
+        {
+            kept.set( leaf );
+            continue;
+        }
+
+        const OptionTreeItem* item = m_leaves.at( leaf );
+        const OptionTreeItem* group = item->parentItem();
+        QVector< int > siblings;
+        if ( group && group->isDistinct() )
+        {
+            for ( int i = 0; i < group->childCount(); ++i )
+            {
+                if ( group->child( i ) != item )
+                {
+                    collectLeaves( group->child( i ), siblings );
+                }
+            }
+        }
+        auto isChosen = [ & ]( int sibling )
+        { return mask.test( sibling ) && ( m_touched.test( sibling ) || kept.test( sibling ) ); };
+        if ( std::any_of( siblings.cbegin(), siblings.cend(), isChosen ) )
+        {
+            continue;
+        }
+        for ( int sibling : std::as_const( siblings ) )
+        {
+            mask.set( sibling, false );
+        }
+        mask.set( leaf );
+        kept.set( leaf );
+    }
+    applySelectionMask( mask );
+}
+
+const OptionModel::StringTable*
+OptionModel::stringTable( const QString& localeName ) const
+{
+    auto it = m_stringTables.constFind( localeName );
+    if ( it == m_stringTables.cend() )
+    {
+        const int cut = localeName.indexOf( QRegularExpression( QStringLiteral( "[_@]" ) ) );
+        if ( cut > 0 )
+        {
+            it = m_stringTables.constFind( localeName.left( cut ) );
+        }
+    }
+    return it == m_stringTables.cend() ? nullptr : &it.value();
+}
+
+void
+OptionModel::setLocale( const QString& localeName )
+{
+    m_localeName = localeName;
+    const StringTable* strings = stringTable( localeName );
+    if ( strings != m_strings )
+    {
+        m_strings = strings;
+        // Names and descriptions are both translated
+        emitChildrenChanged( QModelIndex(), QVector< int > { Qt::DisplayRole }, NameColumn, DescriptionColumn );
+    }
+}
+
+QVector< QPair< int, QVariantMap > >
+OptionModel::leafProbes() const
+{
+    QVector< QPair< int, QVariantMap > > probes;
+    for ( int leaf = 0; leaf < m_leaves.count(); ++leaf )
+    {
+        if ( !m_leaves.at( leaf )->probe().isEmpty() )
+        {
+            probes.append( { leaf, m_leaves.at( leaf )->probe() } );
+        }
+    }
+    return probes;
+}
+
+QHash< int, QString >
+OptionModel::leafInputs() const
+{
+    QHash< int, QString > inputs;
+    for ( int leaf = 0; leaf < m_leaves.count(); ++leaf )
+    {
+        const OptionTreeItem* item = m_leaves.at( leaf );
+        if ( item->isEditable() && !item->input().isEmpty() )
+        {
+            inputs.insert( leaf, item->input() );
+        }
+    }
+    return inputs;
+}
+
+void
+OptionModel::setLeafInputs( const QHash< int, QString >& inputs )
+{
+    bool changed = false;
+    for ( auto it = inputs.cbegin(); it != inputs.cend(); ++it )
+    {
+        if ( it.key() < 0 || it.key() >= m_leaves.count() || !m_leaves.at( it.key() )->isEditable() )
+        {
+            continue;
+        }
+        OptionTreeItem* item = m_leaves.at( it.key() );
+        item->setInput( it.value() );
+        noteWidthHint( InputColumn, it.value(), itemDepth( item, m_rootItem ), item->serial() );
+        changed = true;
+    }
+    if ( changed )
+    {
+        emit headerDataChanged( Qt::Horizontal, InputColumn, InputColumn );
+        emitChildrenChanged(
+            QModelIndex(), QVector< int > { Qt::DisplayRole, Qt::EditRole }, InputColumn, InputColumn );
+    }
+}
+
+int
+OptionModel::itemSerial( const QModelIndex& index ) const
+{
+    if ( !m_rootItem || !index.isValid() )
+    {
+        return -1;
+    }
+    return static_cast< const OptionTreeItem* >( index.internalPointer() )->serial();
+}
+
 Qt::ItemFlags
 OptionModel::flags( const QModelIndex& index ) const
 {
@@ -284,9 +677,69 @@ OptionModel::headerData( int section, Qt::Orientation orientation, int role ) co
             return tr( "Input (Optional)" );
         }
     }
+    if ( orientation == Qt::Horizontal && role == WidthHintRole && 0 <= section && section < columnCount() )
+    {
+        QVariantList hints;
+        for ( const auto& hint : m_widthHints[ section ] )
+        {
+            hints.append( QVariantMap { { "text", hint.text }, { "depth", hint.depth } } );
+        }
+        return hints;
+    }
     return QVariant();
 }
 
+void
+OptionModel::noteWidthHint( int column, const QString& text, int depth, int serial )
+{
+    static constexpr const int maxHints = 8;
+    // Indentation counts for roughly as much as a few characters
+    const auto weight = []( const QString& t, int d ) { return t.length() + 3 * d; };
+
+    auto& hints = m_widthHints[ column ];
+    if ( serial >= 0 )
+    {
+        auto isItem = [ serial ]( const WidthHint& h ) { return h.serial == serial; };
+        const auto old = std::find_if( hints.begin(), hints.end(), isItem );
+        if ( old != hints.end() )
+        {
+            const bool full = hints.count() >= maxHints;
+            hints.erase( old );
+            if ( full )
+            {
+                // An item that did not make the list may be the widest now
+                refillWidthHints( column );
+                return;
+            }
+        }
+    }
+    const int w = weight( text, depth );
+    if ( hints.count() >= maxHints && weight( hints.last().text, hints.last().depth ) >= w )
+    {
+        return;
+    }
+    auto it = std::find_if(
+        hints.begin(), hints.end(), [ & ]( const WidthHint& h ) { return weight( h.text, h.depth ) < w; } );
+    hints.insert( it, WidthHint { text, depth, serial } );
+    if ( hints.count() > maxHints )
+    {
+        hints.removeLast();
+    }
+}
+
+void
+OptionModel::refillWidthHints( int column )
+{
+    m_widthHints[ column ].clear();
+    for ( const OptionTreeItem* item : std::as_const( m_items ) )
+    {
+        if ( item != m_rootItem )
+        {
+            noteWidthHint( column, item->data( column ).toString(), itemDepth( item, m_rootItem ), item->serial() );
+        }
+    }
+}
+
 void
 OptionModel::setSelections( const QStringList& selectNames )
 {
@@ -412,9 +865,119 @@ OptionModel::setupModelData( const QVariantList& l )
     delete m_rootItem;
     m_rootItem = new OptionTreeItem();
     setupModelData( l, m_rootItem );
+    rebuildIndex();
     endResetModel();
 }
 
+void
+OptionModel::rebuildIndex()
+{
+    m_items.clear();
+    m_leaves.clear();
+    m_leafBySerial.clear();
+    m_leafByName.clear();
+    m_leafByOperation.clear();
+    m_operationWords = 0;
+    m_startExpanded.clear();
+    m_searchIndex.clear();
+    m_strings = nullptr;
+    m_stringTables.clear();
+    for ( auto& hints : m_widthHints )
+    {
+        hints.clear();
+    }
+    if ( !m_rootItem )
+    {
+        return;
+    }
+
+    // Pre-order walk with an explicit stack; children are pushed
+    // in reverse so that they are numbered in display order.
+    // The root has depth -1, so that top-level rows have depth 0.
+    struct Entry
+    {
+        OptionTreeItem* item;
+        int depth;
+        int row;
+    };
+    QVector< Entry > stack { { m_rootItem, -1, 0 } };
+    while ( !stack.isEmpty() )
+    {
+        const auto [ item, depth, row ] = stack.takeLast();
+        const int serial = m_items.count();
+        item->setSerial( serial );
+        m_items.append( item );
+        m_leafBySerial.append( -1 );
+        if ( item != m_rootItem )
+        {
+            m_searchIndex.add( serial, item->name() );
+            m_searchIndex.add( serial, item->description() );
+            for ( int column = NameColumn; column <= InputColumn; ++column )
+            {
+                // Only inputs change, and replace the hint of their item
+                noteWidthHint( column, item->data( column ).toString(), depth, column == InputColumn ? serial : -1 );
+            }
+            // Translations are searchable in any language, and may be wider
+            const auto& names = item->nameTranslations();
+            for ( auto it = names.cbegin(); it != names.cend(); ++it )
+            {
+                auto& table = m_stringTables[ it.key() ].names;
+                table.resize( serial + 1 );
+                table[ serial ] = it.value();
+                m_searchIndex.add( serial, it.value() );
+                noteWidthHint( NameColumn, it.value(), depth );
+            }
+            const auto& descriptions = item->descriptionTranslations();
+            for ( auto it = descriptions.cbegin(); it != descriptions.cend(); ++it )
+            {
+                auto& table = m_stringTables[ it.key() ].descriptions;
+                table.resize( serial + 1 );
+                table[ serial ] = it.value();
+                m_searchIndex.add( serial, it.value() );
+                noteWidthHint( DescriptionColumn, it.value(), depth );
+            }
+            if ( item->isGroup() && item->expandOnStart() && item->childCount() > 0 )
+            {
+                m_startExpanded.append( { item, row } );
+            }
+            if ( item->isOption() )
+            {
+                const int leaf = m_leaves.count();
+                m_leaves.append( item );
+                m_leafBySerial[ serial ] = leaf;
+                for ( const auto& key : { item->optionName(), item->description() } )
+                {
+                    if ( !key.isEmpty() && !m_leafByName.contains( key ) )
+                    {
+                        m_leafByName.insert( key, leaf );
+                    }
+                }
+                const QString& operation = item->description();
+                const int equals = item->isEditable() ? int( operation.indexOf( '=' ) ) : -1;
+                const QString key = equals >= 0 ? operation.left( equals + 1 ) : operation;
+                if ( !key.isEmpty() && !m_leafByOperation.contains( key ) )
+                {
+                    m_leafByOperation.insert( key, leaf );
+                    m_operationWords = qMax( m_operationWords, int( key.count( ' ' ) ) + 1 );
+                }
+            }
+        }
+        for ( int i = item->childCount() - 1; i >= 0; --i )
+        {
+            stack.append( { item->child( i ), depth + 1, i } );
+        }
+    }
+    m_searchIndex.finish( m_items.count() );
+    for ( auto& table : m_stringTables )
+    {
+        table.names.resize( m_items.count() );
+        table.descriptions.resize( m_items.count() );
+    }
+    m_strings = stringTable( m_localeName );
+    // The leaves are numbered afresh
+    m_touched = SelectionMask( m_leaves.count() );
+}
+
 void
 OptionModel::appendModelData( const QVariantList& groupList )
 {
@@ -444,6 +1007,7 @@ OptionModel::appendModelData( const QVariantList& groupList )
 
         // Add the new data to the model
         setupModelData( groupList, m_rootItem );
+        rebuildIndex();
 
         endResetModel();
     }
@@ -12,11 +12,14 @@
 #ifndef PACKAGEMODEL_H
 #define PACKAGEMODEL_H
 
+#include "OptionSearchIndex.h"
 #include "OptionTreeItem.h"
+#include "SelectionMask.h"
 
 #include <functional>
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QObject>
 #include <QString>
 
@@ -37,9 +40,16 @@ public:
 
     /* The only interesting roles are DisplayRole (with text depending
      * on the column, and MetaExpandRole which tells if an index
-     * should be initially expanded.
+     * should be initially expanded. SpacerRole is a cheap boolean
+     * for the view's paint code: true for rows with an empty name.
      */
     static constexpr const int MetaExpandRole = Qt::UserRole + 1;
+    static constexpr const int SpacerRole = Qt::UserRole + 2;
+    /* Header role (horizontal): a list of maps with keys *text* and
+     * *depth*, the candidates for the widest cell in that column.
+     * Views measure these once instead of sizing to contents.
+     */
+    static constexpr const int WidthHintRole = Qt::UserRole + 3;
 
     explicit OptionModel( QObject* parent = nullptr );
     ~OptionModel() override;
@@ -89,14 +99,154 @@ public:
 
     void setUpdateNextCall( std::function<void(bool)> fn );
 
+    /// @brief Serial number (see OptionTreeItem::serial()) of the item at @p index, or -1
+    int itemSerial( const QModelIndex& index ) const;
+
+    /** @brief Search index over the names and descriptions
+     *
+     * The index is rebuilt every time the model data is (re)loaded,
+     * so it is always consistent with the item serials.
+     */
+    const OptionSearchIndex& searchIndex() const { return m_searchIndex; }
+
+    /** @brief Indexes of groups that should be expanded on start, at any depth
+     *
+     * The list is collected while the model is built, in display order,
+     * so a view can apply it in a single batch.
+     */
+    QModelIndexList startExpandedIndexes() const;
+
+    /// @brief Number of options (leaves); the size of a SelectionMask
+    int leafCount() const { return m_leaves.count(); }
+
+    /** @brief Leaf number of the option called @p name, or -1
+     *
+     * Options are found by their name or by their description, which
+     * is the operation written out (e.g. "DEBUG=2"). When several
+     * options share a name, the first one (in display order) is found.
+     */
+    int findLeaf( const QString& name ) const { return m_leafByName.value( name, -1 ); }
+
+    /** @brief The options in @p text, a space-separated string of operations
+     *
+     * This reads back the *options* string, where each selected option
+     * is written as its operation (description and input). At each
+     * position the longest operation that fits wins, so operations
+     * with spaces in them (e.g. "EGL=mesa MESA_LLVMPIPE=1") are found
+     * whole; an editable option (e.g. "SLEEP_STATE=") takes the text
+     * up to the next space as its input. Operations are looked up in a
+     * hash, a few words at a time. Words that are no operation are
+     * looked up with findLeaf(), and otherwise added to @p unknown.
+     *
+     * Returns (leaf number, input) pairs, in the order of @p text.
+     */
+    QVector< QPair< int, QString > > findOperations( const QString& text, QStringList* unknown = nullptr ) const;
+
+    /// @brief The currently selected options
+    SelectionMask selectionMask() const;
+
+    /** @brief Selects exactly the options in @p mask
+     *
+     * Only options whose bit differs from the current selection are
+     * touched, a word at a time. Their ancestors are then recounted in
+     * one pass from the bottom up, and the change is announced once.
+     * Options in immutable groups keep their state.
+     */
+    void applySelectionMask( const SelectionMask& mask );
+
+    /** @brief Selects the options in @p hits, whose probes hold
+     *
+     * Unlike applySelectionMask(), this adds to the selection: in a
+     * distinct group, a hit replaces the selected sibling (the first
+     * hit in a group wins). Options that the user has checked or
+     * unchecked keep their state, and so does a distinct group in
+     * which the user has chosen.
+     */
+    void applyProbeHits( const SelectionMask& hits );
+
+    /** @brief Shows translated names in the language @p localeName
+     *
+     * The *name[xx]* translations are compiled into one string table
+     * per locale when the model is loaded, so switching language is
+     * a lookup here and one round of dataChanged(), and data() does
+     * not look up translations while painting. Falls back to the
+     * language without country (e.g. "pt" for "pt_BR"), then to the
+     * untranslated text.
+     */
+    void setLocale( const QString& localeName );
+
+    /// @brief The options that have a *probe*, as (leaf number, probe) pairs
+    QVector< QPair< int, QVariantMap > > leafProbes() const;
+
+    /// @brief Inputs of the editable options that have one, by leaf number
+    QHash< int, QString > leafInputs() const;
+    /// @brief Sets the inputs of editable options, by leaf number
+    void setLeafInputs( const QHash< int, QString >& inputs );
+
 private:
     friend class ItemTests;
 
     void setupModelData( const QVariantList& l, OptionTreeItem* parent );
 
+    /// @brief Assigns serials to all items and rebuilds the search index
+    void rebuildIndex();
+
+    /** @brief Emits dataChanged() for the children of @p parent, recursively
+     *
+     * Proxy models drop dataChanged() signals whose corners have different
+     * parents, so changes that ripple through a subtree are announced
+     * once per parent, over the columns @p firstColumn to @p lastColumn.
+     */
+    void emitChildrenChanged( const QModelIndex& parent,
+                              const QVector< int >& roles,
+                              int firstColumn = NameColumn,
+                              int lastColumn = NameColumn );
+
+    /// @brief Appends the leaf numbers of the options in @p item (itself, or below it) to @p leaves
+    void collectLeaves( const OptionTreeItem* item, QVector< int >& leaves ) const;
+
+    struct WidthHint
+    {
+        QString text;
+        int depth = 0;
+        int serial = -1;  ///< Of the item whose input this is, or -1
+    };
+    /** @brief Remembers @p text if it is among the longest in @p column
+     *
+     * Length in characters is only a proxy for the rendered width, so
+     * a handful of candidates is kept for the view to measure. With a
+     * @p serial, @p text replaces the earlier hint of that item, so that
+     * the column narrows again when an input gets shorter.
+     */
+    void noteWidthHint( int column, const QString& text, int depth, int serial = -1 );
+    /// @brief Collects the hints of @p column afresh, from the items
+    void refillWidthHints( int column );
+
+    /// @brief Translated names and descriptions, by serial; null strings are untranslated
+    struct StringTable
+    {
+        QVector< QString > names;
+        QVector< QString > descriptions;
+    };
+    const StringTable* stringTable( const QString& localeName ) const;
+
     std::function<void(bool)> m_nextUpdateCall{};
 
     OptionTreeItem* m_rootItem = nullptr;
+    QVector< OptionTreeItem* > m_items;  ///< All items, indexed by serial
+    QVector< OptionTreeItem* > m_leaves;  ///< All options, indexed by leaf number
+    QVector< int > m_leafBySerial;  ///< Leaf number of each item, or -1 for groups
+    SelectionMask m_touched;  ///< Options that the user has changed, by leaf number
+    QHash< QString, int > m_leafByName;
+    /// @brief By operation; for editable options, up to and including the "="
+    QHash< QString, int > m_leafByOperation;
+    int m_operationWords = 0;  ///< Most words in a key of m_leafByOperation
+    OptionSearchIndex m_searchIndex;
+    QHash< QString, StringTable > m_stringTables;  ///< By locale name
+    const StringTable* m_strings = nullptr;  ///< For m_localeName, or nullptr
+    QString m_localeName;
+    QVector< WidthHint > m_widthHints[ 3 ];  ///< Per column, longest first
+    QVector< std::pair< OptionTreeItem*, int > > m_startExpanded;  ///< Item and its row
 };
 
 #endif  // PACKAGEMODEL_H
@@ -0,0 +1,204 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "OptionProbe.h"
+
+#include "OptionsSnapshot.h"
+
+#include "utils/Logger.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+
+namespace OptionProbe
+{
+
+static constexpr quint32 cacheMagic = 0x50524f42;  // "PROB"
+static constexpr qint64 maximumFileSize = 1 << 20;
+
+static QByteArray
+readFile( const QString& path )
+{
+    QFile f( path );
+    return f.open( QIODevice::ReadOnly ) ? f.read( maximumFileSize ) : QByteArray();
+}
+
+static bool
+hasCpuFlag( const QString& flag )
+{
+    // All CPUs list the same flags; read them once per process
+    static const QStringList flags = []
+    {
+        for ( const auto& line : readFile( QStringLiteral( "/proc/cpuinfo" ) ).split( '\n' ) )
+        {
+            if ( line.startsWith( "flags" ) )
+            {
+                return QString::fromLatin1( line.mid( line.indexOf( ':' ) + 1 ) )
+                    .split( ' ', Qt::SkipEmptyParts );
+            }
+        }
+        return QStringList();
+    }();
+    return flags.contains( flag );
+}
+
+static bool
+hasDrmCard()
+{
+    static const QRegularExpression card( QStringLiteral( "^card[0-9]+$" ) );
+    for ( const auto& name : QDir( QStringLiteral( "/sys/class/drm" ) ).entryList( QDir::AllEntries | QDir::System ) )
+    {
+        if ( card.match( name ).hasMatch() )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int
+vendorId( const QString& vendor )
+{
+    static const QHash< QString, int > vendors { { QStringLiteral( "intel" ), 0x8086 },
+                                                 { QStringLiteral( "amd" ), 0x1002 },
+                                                 { QStringLiteral( "nvidia" ), 0x10de },
+                                                 { QStringLiteral( "vmware" ), 0x15ad },
+                                                 { QStringLiteral( "virtio" ), 0x1af4 } };
+    const QString v = vendor.trimmed().toLower();
+    if ( vendors.contains( v ) )
+    {
+        return vendors.value( v );
+    }
+    bool ok = false;
+    const int id = v.startsWith( QStringLiteral( "0x" ) ) ? v.mid( 2 ).toInt( &ok, 16 ) : v.toInt( &ok, 10 );
+    return ok ? id : -1;
+}
+
+static bool
+hasGpuVendor( int vendor )
+{
+    const QDir devices( QStringLiteral( "/sys/bus/pci/devices" ) );
+    for ( const auto& name : devices.entryList( QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot ) )
+    {
+        // PCI class 0x03xxxx is a display controller
+        if ( !readFile( devices.filePath( name + QStringLiteral( "/class" ) ) ).startsWith( "0x03" ) )
+        {
+            continue;
+        }
+        bool ok = false;
+        const QByteArray id = readFile( devices.filePath( name + QStringLiteral( "/vendor" ) ) ).trimmed();
+        if ( id.mid( 2 ).toInt( &ok, 16 ) == vendor && ok )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString
+key( const QVariantMap& probe )
+{
+    QStringList parts;
+    for ( auto it = probe.cbegin(); it != probe.cend(); ++it )
+    {
+        parts.append( it.key() + '=' + it.value().toString() );
+    }
+    return parts.join( '\n' );
+}
+
+bool
+evaluate( const QVariantMap& probe )
+{
+    if ( probe.isEmpty() )
+    {
+        return false;
+    }
+    for ( auto it = probe.cbegin(); it != probe.cend(); ++it )
+    {
+        const QString value = it.value().toString();
+        bool holds = false;
+        if ( it.key() == QStringLiteral( "file" ) )
+        {
+            const QString contains = probe.value( QStringLiteral( "contains" ) ).toString();
+            holds = contains.isEmpty() ? QFile::exists( value ) : readFile( value ).contains( contains.toUtf8() );
+        }
+        else if ( it.key() == QStringLiteral( "contains" ) )
+        {
+            holds = probe.contains( QStringLiteral( "file" ) );
+        }
+        else if ( it.key() == QStringLiteral( "cpuinfo" ) )
+        {
+            holds = hasCpuFlag( value );
+        }
+        else if ( it.key() == QStringLiteral( "drm" ) )
+        {
+            holds = hasDrmCard() == ( value != QStringLiteral( "absent" ) );
+        }
+        else if ( it.key() == QStringLiteral( "gpu-vendor" ) )
+        {
+            const int id = vendorId( value );
+            holds = id >= 0 && hasGpuVendor( id );
+        }
+        else
+        {
+            cWarning() << "Unknown options probe condition" << it.key();
+        }
+        if ( !holds )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static QString
+cachePath()
+{
+    const QString dir = OptionsSnapshot::directory();
+    return dir.isEmpty() ? QString() : QDir( dir ).filePath( QStringLiteral( "options-probes.cache" ) );
+}
+
+QHash< QString, bool >
+loadCache()
+{
+    QByteArray data;
+    if ( !OptionsSnapshot::readPrivateFile( cachePath(), data ) )
+    {
+        return {};
+    }
+    QDataStream stream( data );
+    quint32 magic = 0;
+    QByteArray boot;
+    QHash< QString, bool > cache;
+    stream >> magic >> boot >> cache;
+    if ( stream.status() != QDataStream::Ok || magic != cacheMagic || boot != OptionsSnapshot::bootId() )
+    {
+        return {};
+    }
+    return cache;
+}
+
+void
+saveCache( const QHash< QString, bool >& cache )
+{
+    QByteArray data;
+    {
+        QDataStream stream( &data, QIODevice::WriteOnly );
+        stream << cacheMagic << OptionsSnapshot::bootId() << cache;
+    }
+    QString error;
+    if ( !OptionsSnapshot::writePrivateFile( cachePath(), data, &error ) )
+    {
+        cWarning() << "Could not save options probe cache" << error;
+    }
+}
+
+}  // namespace OptionProbe
@@ -0,0 +1,44 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef OPTIONS_OPTIONPROBE_H
+#define OPTIONS_OPTIONPROBE_H
+
+#include <QHash>
+#include <QString>
+#include <QVariantMap>
+
+/** @brief Hardware probes that decide whether an option starts selected
+ *
+ * An option can have a *probe* map; when every condition in it holds,
+ * the option is selected by default. The conditions are:
+ *
+ *  - *file*: a path (e.g. under /sys) that must exist; with *contains*,
+ *    the file must also contain that text.
+ *  - *cpuinfo*: a CPU flag that must be listed in /proc/cpuinfo.
+ *  - *drm*: "present" or "absent", whether there is a DRM card.
+ *  - *gpu-vendor*: PCI vendor of a display controller, as a number
+ *    (e.g. 0x10de) or one of intel, amd, nvidia, vmware, virtio.
+ *
+ * Probes only read files, and are safe to evaluate on any thread.
+ */
+namespace OptionProbe
+{
+/// @brief Identifies a probe for the per-boot cache; equal probes have equal keys
+QString key( const QVariantMap& probe );
+
+/// @brief Do all the conditions of @p probe hold on this system?
+bool evaluate( const QVariantMap& probe );
+
+/// @brief Probe results of this boot, by key
+QHash< QString, bool > loadCache();
+void saveCache( const QHash< QString, bool >& cache );
+}  // namespace OptionProbe
+
+#endif
@@ -0,0 +1,160 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "OptionSearchIndex.h"
+
+#include <algorithm>
+#include <iterator>
+
+/** @brief Packs a gram of 1..3 UTF-16 code units into one key
+ *
+ * The length goes into the top bits, so that "a" and "a\0\0"
+ * (which cannot occur anyway) do not collide.
+ */
+static quint64
+gramKey( const QChar* gram, int length )
+{
+    quint64 key = quint64( length ) << 48;
+    for ( int i = 0; i < length; ++i )
+    {
+        key |= quint64( gram[ i ].unicode() ) << ( 16 * i );
+    }
+    return key;
+}
+
+static QString
+fold( const QString& s )
+{
+    return s.toCaseFolded();
+}
+
+void
+OptionSearchIndex::clear()
+{
+    m_grams.clear();
+    m_text.clear();
+}
+
+void
+OptionSearchIndex::add( int serial, const QString& text )
+{
+    if ( serial < 0 || text.isEmpty() )
+    {
+        return;
+    }
+
+    const QString folded = fold( text );
+    if ( m_text.count() <= serial )
+    {
+        m_text.resize( serial + 1 );
+    }
+    // Separate texts with a newline, which a query (from a line edit)
+    // will not contain, so that a match never spans two texts.
+    if ( !m_text[ serial ].isEmpty() )
+    {
+        m_text[ serial ].append( QChar( '\n' ) );
+    }
+    m_text[ serial ].append( folded );
+
+    const QChar* p = folded.constData();
+    const int size = folded.size();
+    for ( int start = 0; start < size; ++start )
+    {
+        for ( int length = 1; length <= 3 && start + length <= size; ++length )
+        {
+            Posting& list = m_grams[ gramKey( p + start, length ) ];
+            if ( list.isEmpty() || list.last() != serial )
+            {
+                list.append( serial );
+            }
+        }
+    }
+}
+
+void
+OptionSearchIndex::finish( int itemCount )
+{
+    if ( m_text.count() < itemCount )
+    {
+        m_text.resize( itemCount );
+    }
+    for ( auto& list : m_grams )
+    {
+        list.squeeze();
+    }
+}
+
+const OptionSearchIndex::Posting*
+OptionSearchIndex::posting( const QChar* gram, int length ) const
+{
+    auto it = m_grams.constFind( gramKey( gram, length ) );
+    return it == m_grams.constEnd() ? nullptr : &( it.value() );
+}
+
+QBitArray
+OptionSearchIndex::match( const QString& query ) const
+{
+    const QString folded = fold( query.trimmed() );
+    if ( folded.isEmpty() )
+    {
+        return QBitArray();
+    }
+
+    QBitArray result( m_text.count() );
+    const QChar* q = folded.constData();
+    const int size = folded.size();
+
+    if ( size <= 3 )
+    {
+        // The gram itself is indexed, so the posting list is exact
+        if ( const auto* list = posting( q, size ) )
+        {
+            for ( int serial : *list )
+            {
+                result.setBit( serial );
+            }
+        }
+        return result;
+    }
+
+    // Collect the trigram posting lists; any missing trigram means no match
+    QVector< const Posting* > lists;
+    lists.reserve( size - 2 );
+    for ( int start = 0; start + 3 <= size; ++start )
+    {
+        const auto* list = posting( q + start, 3 );
+        if ( !list )
+        {
+            return result;
+        }
+        lists.append( list );
+    }
+    std::sort( lists.begin(), lists.end(), []( const Posting* a, const Posting* b ) { return a->count() < b->count(); } );
+
+    // Intersect, shortest list first, then verify the survivors
+    Posting candidates = *lists.first();
+    for ( int i = 1; i < lists.count() && !candidates.isEmpty(); ++i )
+    {
+        Posting next;
+        std::set_intersection( candidates.cbegin(),
+                               candidates.cend(),
+                               lists[ i ]->cbegin(),
+                               lists[ i ]->cend(),
+                               std::back_inserter( next ) );
+        candidates.swap( next );
+    }
+    for ( int serial : candidates )
+    {
+        if ( m_text.at( serial ).contains( folded ) )
+        {
+            result.setBit( serial );
+        }
+    }
+    return result;
+}
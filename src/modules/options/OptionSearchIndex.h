@@ -0,0 +1,62 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef OPTIONS_OPTIONSEARCHINDEX_H
+#define OPTIONS_OPTIONSEARCHINDEX_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/** @brief N-gram index over the searchable text of option items
+ *
+ * Items are identified by a serial number (see OptionTreeItem::serial()).
+ * The index is built once, when the model is (re)loaded, by calling
+ * add() for each piece of text of each item and then finish().
+ *
+ * Every 1-, 2- and 3-gram of the case-folded text gets a posting list
+ * of item serials. A query of up to three characters is answered
+ * directly from one posting list; longer queries intersect the posting
+ * lists of their trigrams and only verify the remaining candidates
+ * against their text. No query scans the text of every item.
+ */
+class OptionSearchIndex
+{
+public:
+    void clear();
+
+    /** @brief Add searchable @p text for item @p serial
+     *
+     * Serials must be added in non-decreasing order, so that the
+     * posting lists stay sorted without a separate sort step.
+     */
+    void add( int serial, const QString& text );
+    /// @brief Done adding; @p itemCount is one more than the largest serial
+    void finish( int itemCount );
+
+    /** @brief Items whose text contains @p query (case-insensitive)
+     *
+     * Returns a bit-array with one bit per serial. An empty query
+     * returns an empty array.
+     */
+    QBitArray match( const QString& query ) const;
+
+    int itemCount() const { return m_text.count(); }
+
+private:
+    using Posting = QVector< int >;
+
+    const Posting* posting( const QChar* gram, int length ) const;
+
+    QHash< quint64, Posting > m_grams;
+    QVector< QString > m_text;  ///< Folded text per serial, for verification
+};
+
+#endif
@@ -33,6 +33,23 @@ parentCheckState( OptionTreeItem* parent )
     }
 }
 
+/** @brief Collects the *key[locale]* entries of @p map */
+static OptionTreeItem::Translations
+translations( const QVariantMap& map, const QString& key )
+{
+    OptionTreeItem::Translations result;
+    const QString prefix = key + '[';
+    for ( auto it = map.cbegin(); it != map.cend(); ++it )
+    {
+        const QString& k = it.key();
+        if ( k.startsWith( prefix ) && k.endsWith( ']' ) && k.length() > prefix.length() + 1 )
+        {
+            result.insert( k.mid( prefix.length(), k.length() - prefix.length() - 1 ), it.value().toString() );
+        }
+    }
+    return result;
+}
+
 // static Qt::CheckState initSelected(bool isSelected) {
 //     if (!isSelected) {return;}
 // };
@@ -52,6 +69,8 @@ OptionTreeItem::OptionTreeItem( const QVariantMap& groupData, OptionTag&& parent
     : m_parentItem( parent.parent )
     , m_name( Calamares::getString( groupData, "name" ) )
     , m_optionName( Calamares::getString( groupData, "name" ) )
+    , m_nameTranslations( translations( groupData, QStringLiteral( "name" ) ) )
+    , m_probe( groupData.value( QStringLiteral( "probe" ) ).toMap() )
     , m_isHidden( isHiddenException() || Calamares::getBool( groupData, "hidden", false ) )
     , m_selected( Calamares::getBool( groupData, "selected", false ) ? Qt::Checked : parentCheckState( parent.parent ) )
     , m_description( Calamares::getString( groupData, "description" ) )
@@ -67,6 +86,8 @@ OptionTreeItem::OptionTreeItem( const QVariantMap& groupData, GroupTag&& parent
     : m_parentItem( parent.parent )
     , m_name( Calamares::getString( groupData, "name" ) )
     , m_optionName( Calamares::getString( groupData, "name" ) )
+    , m_nameTranslations( translations( groupData, QStringLiteral( "name" ) ) )
+    , m_descriptionTranslations( translations( groupData, QStringLiteral( "description" ) ) )
     , m_isHidden( isHiddenException() || Calamares::getBool( groupData, "hidden", false ) )
     , m_selected( parentCheckState( parent.parent ) )
     , m_description( Calamares::getString( groupData, "description" ) )
@@ -229,37 +250,43 @@ OptionTreeItem::setSelected( Qt::CheckState isSelected )
     currentItem->updateSelected();
 }
 
-void
-OptionTreeItem::updateSelected()
+Qt::CheckState
+OptionTreeItem::selectionFromChildren() const
 {
     // Figure out checked-state based on the children
     int childrenSelected = 0;
     int childrenPartiallySelected = 0;
-    for ( int i = 0; i < childCount(); i++ )
+    for ( const auto* child : m_childItems )
     {
-        if ( child( i )->isSelected() == Qt::Checked )
+        if ( child->isSelected() == Qt::Checked )
         {
             childrenSelected++;
         }
-        if ( child( i )->isSelected() == Qt::PartiallyChecked )
+        if ( child->isSelected() == Qt::PartiallyChecked )
         {
             childrenPartiallySelected++;
         }
     }
     if ( !childrenSelected && !childrenPartiallySelected )
     {
-        setSelected( Qt::Unchecked );
+        return Qt::Unchecked;
     }
     else if ( isDistinct() || childrenSelected == childCount() )
     {
-        setSelected( Qt::Checked );
+        return Qt::Checked;
     }
     else
     {
-        setSelected( Qt::PartiallyChecked );
+        return Qt::PartiallyChecked;
     }
 }
 
+void
+OptionTreeItem::updateSelected()
+{
+    setSelected( selectionFromChildren() );
+}
+
 void
 OptionTreeItem::setChildrenSelected( Qt::CheckState isSelected )
 {
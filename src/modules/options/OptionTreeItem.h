@@ -11,6 +11,7 @@
 #ifndef PACKAGETREEITEM_H
 #define PACKAGETREEITEM_H
 
+#include <QHash>
 #include <QList>
 #include <QStandardItem>
 #include <QVariant>
@@ -18,6 +19,8 @@
 class OptionTreeItem : public QStandardItem {
  public:
   using List = QList<OptionTreeItem*>;
+  ///@brief Translated texts, by locale name (from *key[locale]* entries)
+  using Translations = QHash<QString, QString>;
 
   ///@brief A tag class to distinguish option-from-map from group-from-map
   struct OptionTag {
@@ -49,9 +52,28 @@ class OptionTreeItem : public QStandardItem {
   const OptionTreeItem* parentItem() const;
 
   QString name() const { return m_name; }
+  /** @brief Is this a spacer row?
+   *
+   * Items with an empty name are not drawn as items, the tree branch
+   * just passes them by. Cheap enough to call from paint code.
+   */
+  bool isSpacer() const { return m_name.isEmpty(); }
   QString optionName() const { return m_optionName; }
 
   QString description() const { return m_description; }
+
+  /** @brief Translations of the name and description
+   *
+   * These come from *name[xx]* and *description[xx]* keys. They are
+   * for display only; the description of an option is its operation,
+   * so only group descriptions are translated. OptionModel compiles
+   * them into per-locale tables.
+   */
+  const Translations& nameTranslations() const { return m_nameTranslations; }
+  const Translations& descriptionTranslations() const { return m_descriptionTranslations; }
+
+  ///@brief The *probe* of an option, see OptionProbe; empty if there is none
+  const QVariantMap& probe() const { return m_probe; }
   QString preScript() const { return m_preScript; }
   QString postScript() const { return m_postScript; }
   QString source() const { return m_source; }
@@ -60,6 +82,14 @@ class OptionTreeItem : public QStandardItem {
   void setInput( QString input ) { m_input = input; };
   bool isEditable() const { return m_editable; }
 
+  /** @brief Position of this item in a pre-order walk of the model
+   *
+   * Assigned by the model once the tree is built; the root is 0.
+   * Items that are not (yet) in a model have serial -1.
+   */
+  int serial() const { return m_serial; }
+  void setSerial( int serial ) { m_serial = serial; }
+
   /** @brief Is this item a group-item?
    *
    * Groups have a (possibly empty) list of options, and a
@@ -140,6 +170,13 @@ class OptionTreeItem : public QStandardItem {
   QString toOperation() const;
 
   void setSelected(Qt::CheckState isSelected);
+  /** @brief Sets the check state of this item only
+   *
+   * Unlike setSelected(), this does not touch the children or the
+   * parent; the caller is responsible for making the tree consistent
+   * again (see OptionModel::applySelectionMask()).
+   */
+  void setSelectedState( Qt::CheckState state ) { m_selected = state; }
   void setChildrenSelected(Qt::CheckState isSelected);
   void selectChildren(QString optionName);
 
@@ -151,6 +188,8 @@ class OptionTreeItem : public QStandardItem {
    * or subgroups; it checks only direct children.
    */
   void updateSelected();
+  /// @brief The state updateSelected() would pick, without applying it
+  Qt::CheckState selectionFromChildren() const;
 
   // QStandardItem methods
   int type() const override;
@@ -173,7 +212,11 @@ class OptionTreeItem : public QStandardItem {
   QString m_name;
   QString m_description;
   QString m_optionName;
+  Translations m_nameTranslations;
+  Translations m_descriptionTranslations;
+  QVariantMap m_probe;
   QString m_input = "";
+  int m_serial = -1;
   Qt::CheckState m_selected = Qt::Unchecked;
 
   // These are only useful for groups
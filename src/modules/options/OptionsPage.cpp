@@ -12,6 +12,7 @@
 
 #include "OptionsPage.h"
 
+#include "OptionFilterModel.h"
 #include "OptionModel.h"
 #include "ui_page_chooser.h"
 
@@ -23,26 +24,33 @@
 #include "utils/Retranslator.h"
 #include "utils/Yaml.h"
 
-#include <QHeaderView>
 #include <QNetworkReply>
 
 OptionsPage::OptionsPage( Config* c, QWidget* parent )
     : QWidget( parent )
     , m_config( c )
     , ui( new Ui::Page_NetInst )
+    , m_filter( new OptionFilterModel( c->model(), this ) )
 {
     ui->setupUi( this );
-    ui->groupswidget->header()->setSectionResizeMode( QHeaderView::ResizeToContents );
-    ui->groupswidget->setModel( c->model() );
+    ui->groupswidget->setModel( m_filter );
+    connect( ui->filterEdit, &QLineEdit::textChanged, this, &OptionsPage::applyFilter );
     connect( c, &Config::statusChanged, ui->chooser_status, &QLabel::setText );
-    connect( c,
-             &Config::titleLabelChanged,
-             [ ui = this->ui ]( const QString title )
-             {
-                 ui->label->setVisible( !title.isEmpty() );
-                 ui->label->setText( title );
-             } );
+    auto setTitle = [ ui = this->ui ]( const QString title )
+    {
+        ui->label->setVisible( !title.isEmpty() );
+        ui->label->setText( title );
+    };
+    connect( c, &Config::titleLabelChanged, setTitle );
     connect( c, &Config::statusReady, this, &OptionsPage::expandGroups );
+    connect( c, &Config::presetsChanged, this, &OptionsPage::updatePresets );
+    connect( ui->presetCombo, QOverload< int >::of( &QComboBox::activated ), c, &Config::applyPreset );
+
+    // The groups may have been loaded before the page was created
+    setTitle( c->titleLabel() );
+    ui->chooser_status->setText( c->status() );
+    updatePresets();
+    expandGroups();
 }
 
 OptionsPage::~OptionsPage() {}
@@ -50,16 +58,44 @@ OptionsPage::~OptionsPage() {}
 void
 OptionsPage::expandGroups()
 {
-    auto* model = m_config->model();
-    // Go backwards because expanding a group may cause rows to appear below it
-    for ( int i = model->rowCount() - 1; i >= 0; --i )
+    QModelIndexList indexes;
+    for ( const auto& index : m_config->model()->startExpandedIndexes() )
     {
-        auto index = model->index( i, 0 );
-        if ( model->data( index, OptionModel::MetaExpandRole ).toBool() )
+        const auto mapped = m_filter->mapFromSource( index );
+        if ( mapped.isValid() )
         {
-            ui->groupswidget->setExpanded( index, true );
+            indexes.append( mapped );
         }
     }
+    ui->groupswidget->expandIndexes( indexes );
+}
+
+void
+OptionsPage::updatePresets()
+{
+    const QStringList names = m_config->presetNames();
+    ui->presetCombo->clear();
+    ui->presetCombo->addItems( names );
+    ui->presetCombo->setPlaceholderText( tr( "Presets" ) );
+    ui->presetCombo->setCurrentIndex( -1 );
+    ui->presetCombo->setVisible( !names.isEmpty() );
+}
+
+void
+OptionsPage::applyFilter( const QString& filter )
+{
+    const bool wasFiltering = m_filter->isFiltering();
+    m_filter->setFilterString( filter );
+    if ( m_filter->isFiltering() )
+    {
+        // Show every match, however deeply nested
+        ui->groupswidget->expandAll();
+    }
+    else if ( wasFiltering )
+    {
+        ui->groupswidget->collapseAll();
+        expandGroups();
+    }
 }
 
 void
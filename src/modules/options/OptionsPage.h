@@ -24,6 +24,7 @@
 
 #include <memory>
 
+class OptionFilterModel;
 class QNetworkReply;
 
 namespace Ui
@@ -43,13 +44,20 @@ public:
     /** @brief Expand entries that should be pre-expanded.
      *
      * Follows the *expanded* key / the startExpanded field in the
-     * group entries of the model. Call this after filling up the model.
+     * group entries of the model, at any depth. Call this after
+     * filling up the model.
      */
     void expandGroups();
 
 private:
+    /// @brief Applies the search string from the filter box
+    void applyFilter( const QString& filter );
+    /// @brief Fills the preset chooser; it is hidden if there are no presets
+    void updatePresets();
+
     Config* m_config;
     Ui::Page_NetInst* ui;
+    OptionFilterModel* m_filter;
 };
 
 #endif  // NETINSTALLPAGE_H
@@ -0,0 +1,323 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "OptionsSchema.h"
+
+#include "utils/Yaml.h"
+
+#include <QStringList>
+
+namespace OptionsSchema
+{
+
+namespace
+{
+
+/** @brief One pass over the groups, converting and checking
+ *
+ * Each function converts one kind of node from the schema, and
+ * returns @c false (having set m_error) at the first violation.
+ */
+class Parser
+{
+public:
+    explicit Parser( Error& error )
+        : m_error( error )
+    {
+    }
+
+    bool groups( const ::YAML::Node& node, QVariantList& out );
+
+private:
+    bool group( const ::YAML::Node& node, QVariantMap& out );
+    bool option( const ::YAML::Node& node, QVariant& out );
+    bool probe( const ::YAML::Node& node, QVariantMap& out );
+
+    bool string( const ::YAML::Node& node, QVariant& out );
+    bool boolean( const ::YAML::Node& node, QVariant& out );
+
+    bool fail( const ::YAML::Node& node, const QString& message )
+    {
+        const auto mark = node.Mark();
+        m_error.line = mark.line + 1;
+        m_error.column = mark.column + 1;
+        m_error.message = message;
+        return false;
+    }
+
+    Error& m_error;
+};
+
+QString
+keyOf( const ::YAML::const_iterator& it )
+{
+    return QString::fromStdString( it->first.as< std::string >() );
+}
+
+/// @brief Is @p key a translation of @p base, like name[nl]?
+bool
+isTranslation( const QString& key, const char* base )
+{
+    const QString prefix = QString::fromLatin1( base ) + '[';
+    return key.startsWith( prefix ) && key.endsWith( ']' ) && key.length() > prefix.length() + 1;
+}
+
+bool
+Parser::string( const ::YAML::Node& node, QVariant& out )
+{
+    // Unquoted YAML like *name: 2024* is still text to the tree,
+    // and an empty value (spacers have no name) is empty text.
+    if ( node.IsNull() )
+    {
+        out = QString();
+        return true;
+    }
+    if ( !node.IsScalar() )
+    {
+        return fail( node, QStringLiteral( "expected a string" ) );
+    }
+    out = QString::fromStdString( node.Scalar() );
+    return true;
+}
+
+bool
+Parser::boolean( const ::YAML::Node& node, QVariant& out )
+{
+    if ( node.IsScalar() )
+    {
+        out = Calamares::YAML::scalarToVariant( node );
+        if ( out.userType() == QMetaType::Bool )
+        {
+            return true;
+        }
+    }
+    return fail( node, QStringLiteral( "expected true or false" ) );
+}
+
+bool
+Parser::groups( const ::YAML::Node& node, QVariantList& out )
+{
+    if ( !node.IsSequence() )
+    {
+        return fail( node, QStringLiteral( "expected a list of groups" ) );
+    }
+    for ( const auto& item : node )
+    {
+        QVariantMap map;
+        if ( !group( item, map ) )
+        {
+            return false;
+        }
+        out.append( map );
+    }
+    return true;
+}
+
+bool
+Parser::group( const ::YAML::Node& node, QVariantMap& out )
+{
+    static const QStringList stringKeys { QStringLiteral( "name" ),        QStringLiteral( "description" ),
+                                          QStringLiteral( "pre-install" ), QStringLiteral( "post-install" ),
+                                          QStringLiteral( "source" ) };
+    static const QStringList boolKeys { QStringLiteral( "hidden" ),       QStringLiteral( "selected" ),
+                                        QStringLiteral( "distinct" ),     QStringLiteral( "critical" ),
+                                        QStringLiteral( "immutable" ),    QStringLiteral( "noncheckable" ),
+                                        QStringLiteral( "expanded" ) };
+
+    if ( !node.IsMap() )
+    {
+        return fail( node, QStringLiteral( "expected a group (a map)" ) );
+    }
+
+    bool haveSubgroups = false;
+    for ( auto it = node.begin(); it != node.end(); ++it )
+    {
+        const QString key = keyOf( it );
+        const ::YAML::Node& value = it->second;
+        QVariant v;
+        if ( stringKeys.contains( key ) || isTranslation( key, "name" ) || isTranslation( key, "description" ) )
+        {
+            if ( !string( value, v ) )
+            {
+                return false;
+            }
+        }
+        else if ( boolKeys.contains( key ) )
+        {
+            if ( !boolean( value, v ) )
+            {
+                return false;
+            }
+        }
+        else if ( key == QStringLiteral( "options" ) )
+        {
+            if ( !value.IsSequence() )
+            {
+                return fail( value, QStringLiteral( "*options* must be a list" ) );
+            }
+            QVariantList options;
+            for ( const auto& item : value )
+            {
+                QVariant o;
+                if ( !option( item, o ) )
+                {
+                    return false;
+                }
+                options.append( o );
+            }
+            v = options;
+        }
+        else if ( key == QStringLiteral( "subgroups" ) )
+        {
+            QVariantList subgroups;
+            if ( !groups( value, subgroups ) )
+            {
+                return false;
+            }
+            haveSubgroups = !subgroups.isEmpty();
+            v = subgroups;
+        }
+        else
+        {
+            v = Calamares::YAML::toVariant( value );
+        }
+        out.insert( key, v );
+    }
+
+    if ( !out.contains( QStringLiteral( "name" ) ) )
+    {
+        return fail( node, QStringLiteral( "a group needs a *name*" ) );
+    }
+    if ( !haveSubgroups && !out.contains( QStringLiteral( "options" ) ) )
+    {
+        return fail( node, QStringLiteral( "a group without *subgroups* needs *options*" ) );
+    }
+    return true;
+}
+
+bool
+Parser::option( const ::YAML::Node& node, QVariant& out )
+{
+    // A bare string is an option with that name
+    if ( node.IsScalar() )
+    {
+        return string( node, out );
+    }
+    if ( !node.IsMap() )
+    {
+        return fail( node, QStringLiteral( "expected an option (a string or a map)" ) );
+    }
+
+    QVariantMap map;
+    for ( auto it = node.begin(); it != node.end(); ++it )
+    {
+        const QString key = keyOf( it );
+        const ::YAML::Node& value = it->second;
+        QVariant v;
+        bool ok = true;
+        if ( key == QStringLiteral( "name" ) || key == QStringLiteral( "description" )
+             || key == QStringLiteral( "default" ) || isTranslation( key, "name" ) )
+        {
+            ok = string( value, v );
+        }
+        else if ( key == QStringLiteral( "selected" ) || key == QStringLiteral( "editable" ) )
+        {
+            ok = boolean( value, v );
+        }
+        else if ( key == QStringLiteral( "probe" ) )
+        {
+            QVariantMap p;
+            ok = probe( value, p );
+            v = p;
+        }
+        else
+        {
+            v = Calamares::YAML::toVariant( value );
+        }
+        if ( !ok )
+        {
+            return false;
+        }
+        map.insert( key, v );
+    }
+
+    if ( !map.contains( QStringLiteral( "name" ) ) || !map.contains( QStringLiteral( "description" ) ) )
+    {
+        return fail( node, QStringLiteral( "an option needs a *name* and a *description*" ) );
+    }
+    out = map;
+    return true;
+}
+
+bool
+Parser::probe( const ::YAML::Node& node, QVariantMap& out )
+{
+    static const QStringList keys { QStringLiteral( "file" ),
+                                    QStringLiteral( "contains" ),
+                                    QStringLiteral( "cpuinfo" ),
+                                    QStringLiteral( "drm" ),
+                                    QStringLiteral( "gpu-vendor" ) };
+    if ( !node.IsMap() )
+    {
+        return fail( node, QStringLiteral( "*probe* must be a map" ) );
+    }
+    for ( auto it = node.begin(); it != node.end(); ++it )
+    {
+        const QString key = keyOf( it );
+        if ( !keys.contains( key ) )
+        {
+            return fail( it->first, QStringLiteral( "unknown probe condition *%1*" ).arg( key ) );
+        }
+        QVariant v;
+        if ( !string( it->second, v ) )
+        {
+            return false;
+        }
+        if ( key == QStringLiteral( "drm" ) && v != QStringLiteral( "present" ) && v != QStringLiteral( "absent" ) )
+        {
+            return fail( it->second, QStringLiteral( "*drm* must be present or absent" ) );
+        }
+        out.insert( key, v );
+    }
+    return true;
+}
+
+}  // namespace
+
+bool
+parseGroups( const ::YAML::Node& document, QVariantList& groups, Error& error )
+{
+    Parser parser( error );
+    QVariantList result;
+
+    if ( document.IsMap() )
+    {
+        const auto groupsNode = document[ "groups" ];
+        if ( !groupsNode )
+        {
+            error = Error { document.Mark().line + 1,
+                            document.Mark().column + 1,
+                            QStringLiteral( "expected a *groups* key" ) };
+            return false;
+        }
+        if ( !parser.groups( groupsNode, result ) )
+        {
+            return false;
+        }
+    }
+    else if ( !parser.groups( document, result ) )
+    {
+        return false;
+    }
+
+    groups = result;
+    return true;
+}
+
+}  // namespace OptionsSchema
@@ -0,0 +1,50 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef OPTIONS_OPTIONSSCHEMA_H
+#define OPTIONS_OPTIONSSCHEMA_H
+
+#include <QString>
+#include <QVariantList>
+
+namespace YAML
+{
+class Node;
+}  // namespace YAML
+
+/** @brief Checks groups data against options.schema.yaml while converting it
+ *
+ * The groups data from a source is converted from YAML to QVariant
+ * and checked against the *group* and *option* definitions of the
+ * schema in the same walk over the nodes. The first violation stops
+ * the walk, with the line and column of the offending node, so that
+ * a bad source never reaches the model.
+ *
+ * Keys that the schema does not know about are converted as usual;
+ * like the schema, the checks only cover the keys the module uses.
+ */
+namespace OptionsSchema
+{
+struct Error
+{
+    int line = 0;  ///< 1-based
+    int column = 0;  ///< 1-based
+    QString message;
+};
+
+/** @brief Converts the groups in @p document to @p groups
+ *
+ * The document is either a list of groups, or a map with a *groups*
+ * key holding that list. Returns @c false, and fills @p error, if the
+ * document does not follow the schema; @p groups is then unchanged.
+ */
+bool parseGroups( const ::YAML::Node& document, QVariantList& groups, Error& error );
+}  // namespace OptionsSchema
+
+#endif
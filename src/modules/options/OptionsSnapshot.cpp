@@ -0,0 +1,233 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "OptionsSnapshot.h"
+
+#include "utils/Logger.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QUrl>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr quint32 snapshotMagic = 0x4f505453;  // "OPTS"
+static constexpr quint16 snapshotVersion = 1;
+static constexpr QDataStream::Version streamVersion = QDataStream::Qt_5_15;
+
+QByteArray
+OptionsSnapshot::bootId()
+{
+    QFile f( QStringLiteral( "/proc/sys/kernel/random/boot_id" ) );
+    return f.open( QIODevice::ReadOnly ) ? f.readAll().trimmed() : QByteArray();
+}
+
+QByteArray
+OptionsSnapshot::checksum( const QStringList& urls, const QVariantList& localGroups )
+{
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    for ( const auto& s : urls )
+    {
+        hash.addData( s.toUtf8() );
+        if ( s == QStringLiteral( "local" ) )
+        {
+            QByteArray data;
+            QDataStream stream( &data, QIODevice::WriteOnly );
+            stream.setVersion( streamVersion );
+            stream << localGroups;
+            hash.addData( data );
+            continue;
+        }
+
+        const QUrl url( s );
+        if ( !url.isLocalFile() )
+        {
+            return QByteArray();
+        }
+        QFile f( url.toLocalFile() );
+        if ( f.open( QIODevice::ReadOnly ) )
+        {
+            hash.addData( &f );
+        }
+        // A missing file is part of the state, too: if it appears
+        // later, the checksum changes.
+    }
+    return hash.result();
+}
+
+QString
+OptionsSnapshot::path( const QStringList& urls )
+{
+    const QString dir = directory();
+    if ( dir.isEmpty() )
+    {
+        return QString();
+    }
+    const QByteArray key = QCryptographicHash::hash( urls.join( '\n' ).toUtf8(), QCryptographicHash::Sha1 );
+    return QDir( dir ).filePath(
+        QStringLiteral( "options-%1.snapshot" ).arg( QString::fromLatin1( key.toHex().left( 12 ) ) ) );
+}
+
+QString
+OptionsSnapshot::directory()
+{
+    const QString base = ::geteuid() == 0 ? QStringLiteral( "/run" ) : qEnvironmentVariable( "XDG_RUNTIME_DIR" );
+    if ( base.isEmpty() )
+    {
+        return QString();
+    }
+    const QString dir = QDir( base ).filePath( QStringLiteral( "calamares" ) );
+    const QByteArray name = QFile::encodeName( dir );
+    if ( ::mkdir( name.constData(), 0700 ) != 0 && errno != EEXIST )
+    {
+        cDebug() << "Cannot make" << dir << "- nothing is kept between runs.";
+        return QString();
+    }
+    struct stat st;
+    if ( ::lstat( name.constData(), &st ) != 0 || !S_ISDIR( st.st_mode ) || st.st_uid != ::geteuid()
+         || ( st.st_mode & 077 ) )
+    {
+        cWarning() << dir << "is not a private directory of the installer; nothing is kept between runs.";
+        return QString();
+    }
+    return dir;
+}
+
+bool
+OptionsSnapshot::readPrivateFile( const QString& path, QByteArray& data )
+{
+    if ( path.isEmpty() )
+    {
+        return false;
+    }
+    const int fd = ::open( QFile::encodeName( path ).constData(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC );
+    if ( fd < 0 )
+    {
+        return false;
+    }
+    struct stat st;
+    if ( ::fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) || st.st_uid != ::geteuid()
+         || ( st.st_mode & ( S_IWGRP | S_IWOTH ) ) )
+    {
+        cWarning() << "Not reading" << path << "- it could have been written by someone else.";
+        ::close( fd );
+        return false;
+    }
+    QFile f;
+    if ( !f.open( fd, QIODevice::ReadOnly, QFileDevice::AutoCloseHandle ) )
+    {
+        ::close( fd );
+        return false;
+    }
+    data = f.readAll();
+    return true;
+}
+
+bool
+OptionsSnapshot::writePrivateFile( const QString& path, const QByteArray& data, QString* error )
+{
+    QSaveFile f( path );
+    if ( path.isEmpty() || !f.open( QIODevice::WriteOnly )
+         || !f.setPermissions( QFileDevice::ReadOwner | QFileDevice::WriteOwner ) || f.write( data ) != data.size()
+         || !f.commit() )
+    {
+        if ( error )
+        {
+            *error = path.isEmpty() ? QStringLiteral( "no private directory" ) : f.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool
+OptionsSnapshot::save( const QString& path ) const
+{
+    QByteArray data;
+    {
+        QDataStream stream( &data, QIODevice::WriteOnly );
+        stream.setVersion( streamVersion );
+        stream << snapshotMagic << snapshotVersion << bootId() << sourcesChecksum << groups;
+        stream << qint32( selection.size() );
+        for ( int i = 0; i < selection.wordCount(); ++i )
+        {
+            stream << selection.word( i );
+        }
+        stream << inputs;
+    }
+
+    QString error;
+    if ( !writePrivateFile( path, data, &error ) )
+    {
+        cWarning() << "Could not save options snapshot to" << path << error;
+        return false;
+    }
+    cDebug() << "Saved options snapshot" << path << data.size() << "bytes.";
+    return true;
+}
+
+OptionsSnapshot
+OptionsSnapshot::load( const QString& path, const QByteArray& sourcesChecksum )
+{
+    QByteArray data;
+    if ( sourcesChecksum.isEmpty() || !readPrivateFile( path, data ) )
+    {
+        return OptionsSnapshot();
+    }
+
+    QDataStream stream( data );
+    stream.setVersion( streamVersion );
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    QByteArray boot;
+    OptionsSnapshot snapshot;
+    stream >> magic >> version;
+    if ( magic != snapshotMagic || version != snapshotVersion )
+    {
+        cDebug() << "Options snapshot" << path << "has an unknown format.";
+        return OptionsSnapshot();
+    }
+    stream >> boot >> snapshot.sourcesChecksum;
+    if ( boot != bootId() || snapshot.sourcesChecksum != sourcesChecksum )
+    {
+        cDebug() << "Options snapshot" << path << "is stale.";
+        return OptionsSnapshot();
+    }
+
+    qint32 size = 0;
+    stream >> snapshot.groups >> size;
+    // The words of the mask must be in what is left, before they are allocated
+    const qint64 words = ( qint64( qMax( size, 0 ) ) + SelectionMask::wordBits - 1 ) / SelectionMask::wordBits;
+    if ( stream.status() != QDataStream::Ok
+         || words * qint64( sizeof( SelectionMask::Word ) ) > stream.device()->bytesAvailable() )
+    {
+        cWarning() << "Options snapshot" << path << "is truncated.";
+        return OptionsSnapshot();
+    }
+    snapshot.selection = SelectionMask( qMax( size, 0 ) );
+    for ( int i = 0; i < snapshot.selection.wordCount(); ++i )
+    {
+        stream >> snapshot.selection.word( i );
+    }
+    stream >> snapshot.inputs;
+    if ( stream.status() != QDataStream::Ok )
+    {
+        cWarning() << "Options snapshot" << path << "is truncated.";
+        return OptionsSnapshot();
+    }
+    return snapshot;
+}
@@ -0,0 +1,82 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef OPTIONS_OPTIONSSNAPSHOT_H
+#define OPTIONS_OPTIONSSNAPSHOT_H
+
+#include "SelectionMask.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+
+/** @brief Loaded groups and selection, saved for a relaunch
+ *
+ * When Calamares is restarted in the same live session, loading the
+ * groups again (maybe over the network) and redoing the selection is
+ * wasted effort. A snapshot holds the groups data as it was loaded,
+ * the selection mask and the inputs of editable options. It is tied
+ * to the boot and to a checksum of the sources, and is only restored
+ * when both still match.
+ */
+struct OptionsSnapshot
+{
+    QByteArray sourcesChecksum;
+    QVariantList groups;
+    SelectionMask selection;
+    QHash< int, QString > inputs;  ///< By leaf number
+
+    bool isValid() const { return !sourcesChecksum.isEmpty() && !groups.isEmpty(); }
+
+    /** @brief Checksum over the groups sources @p urls
+     *
+     * Only sources that can be checked cheaply count: local files,
+     * and the groups from the configuration itself (passed in as
+     * @p localGroups for the "local" source). If any source is on
+     * the network the result is empty, and no snapshot is taken.
+     */
+    static QByteArray checksum( const QStringList& urls, const QVariantList& localGroups );
+
+    /// @brief Identifies this boot; nothing saved in an earlier boot is used
+    static QByteArray bootId();
+
+    /// @brief Where the snapshot for @p urls lives, in directory(); empty if there is no such directory
+    static QString path( const QStringList& urls );
+
+    /** @brief A directory for what the installer keeps between runs
+     *
+     * It is /run/calamares for root, and calamares in $XDG_RUNTIME_DIR
+     * otherwise: made mode 0700, and only used when it is a directory
+     * of the effective user that nobody else can get into. What is in
+     * it is trusted on the next run, so it must not be in /tmp, where
+     * any local user can plant files. Empty if there is none.
+     */
+    static QString directory();
+    /** @brief Reads @p path into @p data, if nobody but us can have written it
+     *
+     * The file must be a regular file (no symlink is followed) of the
+     * effective user, without group or other write permission.
+     */
+    static bool readPrivateFile( const QString& path, QByteArray& data );
+    /// @brief Writes @p data to @p path atomically, readable by the effective user only
+    static bool writePrivateFile( const QString& path, const QByteArray& data, QString* error = nullptr );
+
+    /// @brief Writes the snapshot to @p path, atomically
+    bool save( const QString& path ) const;
+    /** @brief Reads the snapshot from @p path
+     *
+     * Returns an invalid snapshot if there is none, if it is from a
+     * different boot, or if its checksum is not @p sourcesChecksum.
+     */
+    static OptionsSnapshot load( const QString& path, const QByteArray& sourcesChecksum );
+};
+
+#endif
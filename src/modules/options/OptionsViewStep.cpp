@@ -15,11 +15,17 @@
 
 #include "OptionsPage.h"
 
+#include "ViewManager.h"
+#include "utils/Logger.h"
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVBoxLayout>
+
 CALAMARES_PLUGIN_FACTORY_DEFINITION( OptionsViewStepFactory, registerPlugin< OptionsViewStep >(); )
 
 OptionsViewStep::OptionsViewStep( QObject* parent )
     : Calamares::ViewStep( parent )
-    , m_widget( new OptionsPage( &m_config ) )
     , m_nextEnabled( false )
 {
     connect( &m_config, &Config::statusReady, this, &OptionsViewStep::nextIsReady );
@@ -78,6 +84,19 @@ OptionsViewStep::prettyName() const
 QWidget*
 OptionsViewStep::widget()
 {
+    if ( !m_widget )
+    {
+        // The ViewManager asks for every widget at startup; hand it an
+        // empty host and build the page when the step is first shown.
+        // A headless step never gets a page at all.
+        QElapsedTimer timer;
+        timer.start();
+        m_widget = new QWidget;
+        auto* layout = new QVBoxLayout( m_widget );
+        layout->setContentsMargins( 0, 0, 0, 0 );
+        // This is what the step adds to startup; it used to be the page build below
+        cDebug() << "Options step widget made in" << timer.nsecsElapsed() / 1000 << "us at startup.";
+    }
     return m_widget;
 }
 
@@ -120,13 +139,29 @@ OptionsViewStep::jobs() const
 void
 OptionsViewStep::onActivate()
 {
-    m_widget->onActivate();
+    m_active = true;
+    if ( m_config.isHeadless() )
+    {
+        passThrough();
+        return;
+    }
+    if ( !m_page )
+    {
+        QElapsedTimer timer;
+        timer.start();
+        m_page = new OptionsPage( &m_config );
+        widget()->layout()->addWidget( m_page );
+        cDebug() << "Options page built in" << timer.elapsed() << "ms, on first activation instead of at startup.";
+    }
+    m_page->onActivate();
 }
 
 void
 OptionsViewStep::onLeave()
 {
+    m_active = false;
     m_config.finalizeGlobalStorage();
+    m_config.saveSnapshot();
 }
 
 void
@@ -134,12 +169,31 @@ OptionsViewStep::nextIsReady()
 {
     m_nextEnabled = true;
     emit nextStatusChanged( true );
+    if ( m_active && m_config.isHeadless() )
+    {
+        passThrough();
+    }
+}
+
+void
+OptionsViewStep::passThrough()
+{
+    // Only once, unattended; going back to the step shows the (empty) page.
+    if ( !m_passedThrough && isNextEnabled() )
+    {
+        m_passedThrough = true;
+        QTimer::singleShot( 0, Calamares::ViewManager::instance(), &Calamares::ViewManager::next );
+    }
 }
 
 void
 OptionsViewStep::setConfigurationMap( const QVariantMap& configurationMap )
 {
     m_config.setConfigurationMap( configurationMap );
+    if ( m_config.isHeadless() )
+    {
+        cDebug() << "Options are preseeded, no page is shown.";
+    }
 }
 
 void
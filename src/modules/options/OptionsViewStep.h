@@ -55,10 +55,16 @@ public slots:
     void nextIsReady();
 
 private:
+    /// @brief Moves on to the next step, when headless
+    void passThrough();
+
     Config m_config;
 
-    OptionsPage* m_widget;
+    QWidget* m_widget = nullptr;  ///< Host for the page
+    OptionsPage* m_page = nullptr;  ///< Built on first activation
     bool m_nextEnabled = false;
+    bool m_active = false;
+    bool m_passedThrough = false;  ///< Headless step was skipped once
 };
 
 CALAMARES_PLUGIN_FACTORY_DECLARATION( OptionsViewStepFactory )
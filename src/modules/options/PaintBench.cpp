@@ -0,0 +1,131 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+/* Scrolls a GroupsTreeView over a large option tree and reports
+ * frame times. Run it with QT_QPA_PLATFORM=offscreen to measure
+ * the view itself rather than the compositor.
+ */
+
+#include "OptionModel.h"
+#include "groupstreeview.h"
+
+#include "JobQueue.h"
+#include "utils/Logger.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QScrollBar>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <numeric>
+
+class PaintBench : public QObject
+{
+    Q_OBJECT
+public:
+    PaintBench() {}
+    ~PaintBench() override {}
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchScroll_data();
+    void benchScroll();
+
+private:
+    Calamares::JobQueue* m_jobQueue = nullptr;  // OptionTreeItem consults GlobalStorage
+};
+
+void
+PaintBench::initTestCase()
+{
+    Logger::setupLogLevel( Logger::LOGVERBOSE );
+    m_jobQueue = new Calamares::JobQueue( this );
+}
+
+/// @brief Builds @p groups groups of @p options options each; every tenth option is a spacer
+static QVariantList
+makeGroups( int groups, int options )
+{
+    QVariantList groupList;
+    for ( int g = 0; g < groups; ++g )
+    {
+        QVariantList optionList;
+        for ( int o = 0; o < options; ++o )
+        {
+            QVariantMap option;
+            option.insert( "name", o % 10 == 9 ? QString() : QStringLiteral( "Option %1.%2" ).arg( g ).arg( o ) );
+            option.insert( "description", QStringLiteral( "OPTION_%1_%2=1" ).arg( g ).arg( o ) );
+            optionList.append( option );
+        }
+        QVariantMap group;
+        group.insert( "name", QStringLiteral( "Group %1" ).arg( g ) );
+        group.insert( "expanded", true );
+        group.insert( "options", optionList );
+        groupList.append( group );
+    }
+    return groupList;
+}
+
+void
+PaintBench::benchScroll_data()
+{
+    QTest::addColumn< int >( "groups" );
+    QTest::addColumn< int >( "options" );
+
+    QTest::newRow( "1k rows" ) << 10 << 100;
+    QTest::newRow( "10k rows" ) << 100 << 100;
+}
+
+void
+PaintBench::benchScroll()
+{
+    QFETCH( int, groups );
+    QFETCH( int, options );
+
+    OptionModel model;
+    model.setupModelData( makeGroups( groups, options ) );
+
+    GroupsTreeView view;
+    view.resize( 800, 600 );
+    view.setModel( &model );
+    view.expandAll();
+    view.show();
+    QVERIFY( QTest::qWaitForWindowExposed( &view ) );
+
+    QScrollBar* bar = view.verticalScrollBar();
+    const int step = std::max( 1, bar->pageStep() );
+
+    QVector< qint64 > frames;
+    QElapsedTimer timer;
+    for ( int value = bar->minimum(); value <= bar->maximum(); value += step )
+    {
+        timer.start();
+        bar->setValue( value );
+        view.viewport()->repaint();
+        frames.append( timer.nsecsElapsed() );
+    }
+    QVERIFY( !frames.isEmpty() );
+
+    std::sort( frames.begin(), frames.end() );
+    const auto ms = []( qint64 ns ) { return double( ns ) / 1e6; };
+    const qint64 total = std::accumulate( frames.cbegin(), frames.cend(), qint64( 0 ) );
+    cDebug() << "Scrolled" << model.searchIndex().itemCount() << "items in" << frames.count() << "frames:"
+             << "min" << ms( frames.first() ) << "ms,"
+             << "median" << ms( frames.at( frames.count() / 2 ) ) << "ms,"
+             << "p95" << ms( frames.at( ( frames.count() * 95 ) / 100 ) ) << "ms,"
+             << "max" << ms( frames.last() ) << "ms,"
+             << "mean" << ms( total / frames.count() ) << "ms";
+}
+
+QTEST_MAIN( PaintBench )
+
+#include "utils/moc-warnings.h"
+
+#include "PaintBench.moc"
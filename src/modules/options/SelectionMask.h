@@ -0,0 +1,78 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef OPTIONS_SELECTIONMASK_H
+#define OPTIONS_SELECTIONMASK_H
+
+#include <QtGlobal>
+
+#include <vector>
+
+/** @brief One bit per option (leaf) of an OptionModel
+ *
+ * Bit *i* corresponds to OptionModel leaf *i* (see OptionModel::leafCount()).
+ * The bits are stored in 64-bit words so that masks can be compared and
+ * combined a word at a time.
+ */
+class SelectionMask
+{
+public:
+    using Word = quint64;
+    static constexpr int wordBits = 64;
+
+    SelectionMask() = default;
+    explicit SelectionMask( int size )
+        : m_size( size )
+        , m_words( std::size_t( ( size + wordBits - 1 ) / wordBits ), Word( 0 ) )
+    {
+    }
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    int wordCount() const { return int( m_words.size() ); }
+
+    bool test( int bit ) const
+    {
+        return 0 <= bit && bit < m_size && ( m_words[ std::size_t( bit / wordBits ) ] >> ( bit % wordBits ) ) & 1;
+    }
+    void set( int bit, bool on = true )
+    {
+        if ( 0 <= bit && bit < m_size )
+        {
+            const Word b = Word( 1 ) << ( bit % wordBits );
+            Word& w = m_words[ std::size_t( bit / wordBits ) ];
+            w = on ? ( w | b ) : ( w & ~b );
+        }
+    }
+
+    Word word( int index ) const { return m_words[ std::size_t( index ) ]; }
+    Word& word( int index ) { return m_words[ std::size_t( index ) ]; }
+
+    bool operator==( const SelectionMask& other ) const
+    {
+        return m_size == other.m_size && m_words == other.m_words;
+    }
+    bool operator!=( const SelectionMask& other ) const { return !( *this == other ); }
+
+    SelectionMask& operator|=( const SelectionMask& other )
+    {
+        const int n = qMin( wordCount(), other.wordCount() );
+        for ( int i = 0; i < n; ++i )
+        {
+            m_words[ std::size_t( i ) ] |= other.m_words[ std::size_t( i ) ];
+        }
+        return *this;
+    }
+
+private:
+    int m_size = 0;
+    std::vector< Word > m_words;
+};
+
+#endif
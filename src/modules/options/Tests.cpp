@@ -43,6 +43,8 @@ private Q_SLOTS:
     void testGroup();
     void testCompare();
     void testModel();
+    void testFindOperations();
+    void testInputWidthHints();
     void testExampleFiles();
 
     void testUrlFallback_data();
@@ -125,6 +127,19 @@ static const char doc_with_expanded[] =
 "    - ccr\n"
 "    - base-devel\n"
 "    - bash\n";
+
+static const char doc_operations[] =
+"- name: \"Graphics\"\n"
+"  options:\n"
+"    - name: \"Mesa\"\n"
+"      description: \"EGL=mesa\"\n"
+"    - name: \"Mesa, in software\"\n"
+"      description: \"EGL=mesa MESA_LLVMPIPE=1\"\n"
+"    - name: \"Sleep state\"\n"
+"      description: \"SLEEP_STATE=\"\n"
+"      editable: true\n"
+"      default: \"mem\"\n"
+"    - quiet\n";
 // *INDENT-ON*
 // clang-format on
 
@@ -306,6 +321,61 @@ ItemTests::testModel()
     QVERIFY( *( m2.m_rootItem->child( 0 ) ) != *group );
 }
 
+void
+ItemTests::testFindOperations()
+{
+    OptionModel m( nullptr );
+    m.setupModelData( Calamares::YAML::sequenceToVariant( YAML::Load( doc_operations ) ) );
+    QCOMPARE( m.leafCount(), 4 );
+
+    QStringList unknown;
+    const auto found
+        = m.findOperations( QStringLiteral( "EGL=mesa MESA_LLVMPIPE=1  SLEEP_STATE=freeze quiet EGL=mesa nosuch" ),
+                            &unknown );
+    using Found = QVector< QPair< int, QString > >;
+    // The longest operation wins; the editable one takes its input
+    QCOMPARE( found,
+              Found( { { 1, QString() },
+                       { 2, QStringLiteral( "freeze" ) },
+                       { 3, QString() },
+                       { 0, QString() } } ) );
+    QCOMPARE( unknown, QStringList { QStringLiteral( "nosuch" ) } );
+
+    // An empty input, and a fixed operation that is only the start of a word
+    unknown.clear();
+    QCOMPARE( m.findOperations( QStringLiteral( "SLEEP_STATE= EGL=mesa2" ), &unknown ),
+              Found( { { 2, QString() } } ) );
+    QCOMPARE( unknown, QStringList { QStringLiteral( "EGL=mesa2" ) } );
+}
+
+void
+ItemTests::testInputWidthHints()
+{
+    OptionModel m( nullptr );
+    m.setupModelData( Calamares::YAML::sequenceToVariant( YAML::Load( doc_operations ) ) );
+    const QModelIndex sleep = m.index( 2, OptionModel::InputColumn, m.index( 0, 0 ) );
+    QVERIFY( sleep.isValid() );
+
+    auto hints = [ &m ]()
+    {
+        QStringList texts;
+        for ( const auto& v : m.headerData( OptionModel::InputColumn, Qt::Horizontal, OptionModel::WidthHintRole )
+                                  .toList() )
+        {
+            texts.append( v.toMap().value( "text" ).toString() );
+        }
+        return texts;
+    };
+    const QString wide = QStringLiteral( "a-very-long-sleep-state-that-nobody-types" );
+    QVERIFY( m.setData( sleep, wide, Qt::EditRole ) );
+    QCOMPARE( hints().first(), wide );
+
+    // A shorter input replaces the wide one, so the column narrows again
+    QVERIFY( m.setData( sleep, QStringLiteral( "mem" ), Qt::EditRole ) );
+    QVERIFY( !hints().contains( wide ) );
+    QCOMPARE( hints().count( QStringLiteral( "mem" ) ), 1 );
+}
+
 void
 ItemTests::testExampleFiles()
 {
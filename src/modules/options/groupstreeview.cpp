@@ -8,10 +8,149 @@
  */
 #include "groupstreeview.h"
 
+#include "OptionModel.h"
+
 #include "utils/Logger.h"
 
+#include <QEvent>
+#include <QFontMetrics>
+#include <QHeaderView>
 #include <QPainter>
 
+#include <algorithm>
+
+GroupsTreeView::GroupsTreeView( QWidget* parent )
+    : QTreeView( parent )
+{
+    // All rows are single-line text with a checkbox, so the view
+    // does not need to ask every row for its size hint.
+    setUniformRowHeights( true );
+    header()->setSectionResizeMode( QHeaderView::Interactive );
+}
+
+void
+GroupsTreeView::setModel( QAbstractItemModel* model )
+{
+    for ( const auto& c : m_modelConnections )
+    {
+        disconnect( c );
+    }
+    m_modelConnections.clear();
+
+    QTreeView::setModel( model );
+    if ( model )
+    {
+        // Check-state changes do not change any text, so plain
+        // dataChanged() is not watched: edits of the input column
+        // announce themselves through headerDataChanged().
+        m_modelConnections
+            << connect( model, &QAbstractItemModel::modelReset, this, &GroupsTreeView::scheduleFitColumns )
+            << connect( model, &QAbstractItemModel::headerDataChanged, this, &GroupsTreeView::scheduleFitColumns );
+    }
+    scheduleFitColumns();
+}
+
+void
+GroupsTreeView::expandIndexes( const QModelIndexList& indexes )
+{
+    if ( indexes.isEmpty() )
+    {
+        return;
+    }
+
+    setUpdatesEnabled( false );
+    // With a layout pending, expand() only records the expanded state;
+    // the pending layout then picks all of them up at once.
+    scheduleDelayedItemsLayout();
+    for ( const auto& index : indexes )
+    {
+        setExpanded( index, true );
+    }
+    setUpdatesEnabled( true );
+}
+
+void
+GroupsTreeView::scheduleFitColumns()
+{
+    if ( !m_fitPending )
+    {
+        m_fitPending = true;
+        QMetaObject::invokeMethod( this, &GroupsTreeView::fitColumns, Qt::QueuedConnection );
+    }
+}
+
+void
+GroupsTreeView::fitColumns()
+{
+    m_fitPending = false;
+    auto* m = model();
+    if ( !m )
+    {
+        return;
+    }
+
+    const QFontMetrics metrics( font() );
+    const QFontMetrics headerMetrics( header()->font() );
+    const int margin = 2 * ( style()->pixelMetric( QStyle::PM_FocusFrameHMargin, nullptr, this ) + 1 );
+    const int checkbox = style()->pixelMetric( QStyle::PM_IndicatorWidth, nullptr, this )
+        + style()->pixelMetric( QStyle::PM_CheckBoxLabelSpacing, nullptr, this );
+    const int rootIndent = rootIsDecorated() ? 1 : 0;
+
+    for ( int column = 0; column < m->columnCount(); ++column )
+    {
+        int width = headerMetrics.horizontalAdvance( m->headerData( column, Qt::Horizontal ).toString() ) + 2 * margin;
+        for ( const auto& v : m->headerData( column, Qt::Horizontal, OptionModel::WidthHintRole ).toList() )
+        {
+            const auto hint = v.toMap();
+            int w = metrics.horizontalAdvance( hint.value( "text" ).toString() ) + margin;
+            if ( column == OptionModel::NameColumn )
+            {
+                w += indentation() * ( hint.value( "depth" ).toInt() + rootIndent ) + checkbox;
+            }
+            width = std::max( width, w );
+        }
+        setColumnWidth( column, width );
+    }
+}
+
+const QStyleOptionViewItem&
+GroupsTreeView::branchOption() const
+{
+    if ( !m_branchOptionValid )
+    {
+#if QT_VERSION < QT_VERSION_CHECK( 6, 0, 0 )
+        m_branchOption = viewOptions();
+#else
+        m_branchOption = QStyleOptionViewItem();
+        initViewItemOption( &m_branchOption );
+#endif
+        m_branchOption.state = QStyle::State_Sibling;
+        m_branchOptionValid = true;
+    }
+    return m_branchOption;
+}
+
+void
+GroupsTreeView::changeEvent( QEvent* event )
+{
+    switch ( event->type() )
+    {
+    case QEvent::StyleChange:
+    case QEvent::PaletteChange:
+    case QEvent::FontChange:
+        m_branchOptionValid = false;
+        scheduleFitColumns();
+        break;
+    case QEvent::LayoutDirectionChange:
+    case QEvent::EnabledChange:
+        m_branchOptionValid = false;
+        break;
+    default:
+        break;
+    }
+    QTreeView::changeEvent( event );
+}
+
 void
 GroupsTreeView::drawBranches( QPainter* painter, const QRect& rect, const QModelIndex& index ) const
 {
@@ -19,16 +158,9 @@ GroupsTreeView::drawBranches( QPainter* painter, const QRect& rect, const QModel
 
     // Empty names are handled specially: don't draw them as items,
     // so the "branch" seems to just pass them by.
-    const QString s = index.data().toString();
-    if ( s.isEmpty() )
+    if ( index.data( OptionModel::SpacerRole ).toBool() )
     {
-#if QT_VERSION < QT_VERSION_CHECK( 6, 0, 0 )
-        QStyleOptionViewItem opt = viewOptions();
-#else
-        QStyleOptionViewItem opt;
-        initViewItemOption( &opt );
-#endif
-        opt.state = QStyle::State_Sibling;
+        QStyleOptionViewItem opt = branchOption();
         opt.rect = QRect( !isRightToLeft() ? rect.left() : rect.right() + 1, rect.top(), indentation(), rect.height() );
         painter->eraseRect( opt.rect );
         style()->drawPrimitive( QStyle::PE_IndicatorBranch, &opt, painter, this );
@@ -6,13 +6,45 @@
  *   Calamares is Free Software: see the License-Identifier above.
  *
  */
+#include <QStyleOptionViewItem>
 #include <QTreeView>
+#include <QVector>
 
 class GroupsTreeView : public QTreeView
 {
 public:
-    using QTreeView::QTreeView;
+    explicit GroupsTreeView( QWidget* parent = nullptr );
+
+    void setModel( QAbstractItemModel* model ) override;
+
+    /** @brief Sizes the columns from the model's width hints
+     *
+     * Measures the candidates from OptionModel::WidthHintRole with the
+     * current font, instead of having the header measure every visible
+     * row on each layout change. Called automatically when the model
+     * data changes; multiple changes in one event-loop pass are sized once.
+     */
+    void fitColumns();
+
+    /** @brief Expands all of @p indexes with a single relayout
+     *
+     * Expanding one index at a time may lay out the tree for each
+     * one; here the layout is deferred until all are recorded.
+     */
+    void expandIndexes( const QModelIndexList& indexes );
 
 protected:
     virtual void drawBranches( QPainter* painter, const QRect& rect, const QModelIndex& index ) const override;
+    void changeEvent( QEvent* event ) override;
+
+private:
+    /// @brief Style option for spacer branches, initialized on first use
+    const QStyleOptionViewItem& branchOption() const;
+
+    void scheduleFitColumns();
+
+    mutable QStyleOptionViewItem m_branchOption;
+    mutable bool m_branchOptionValid = false;
+    bool m_fitPending = false;
+    QVector< QMetaObject::Connection > m_modelConnections;
 };
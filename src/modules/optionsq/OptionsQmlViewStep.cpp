@@ -0,0 +1,83 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "OptionsQmlViewStep.h"
+
+CALAMARES_PLUGIN_FACTORY_DEFINITION( OptionsQmlViewStepFactory, registerPlugin< OptionsQmlViewStep >(); )
+
+OptionsQmlViewStep::OptionsQmlViewStep( QObject* parent )
+    : Calamares::QmlViewStep( parent )
+{
+    connect( &m_config, &Config::statusReady, this, &OptionsQmlViewStep::nextIsReady );
+
+    m_config.model()->setUpdateNextCall( [ this ]( bool enabled ) { this->updateNextEnabled( enabled ); } );
+}
+
+QString
+OptionsQmlViewStep::prettyName() const
+{
+    return m_config.sidebarLabel();
+}
+
+bool
+OptionsQmlViewStep::isNextEnabled() const
+{
+    return !m_config.required() || m_nextEnabled;
+}
+
+bool
+OptionsQmlViewStep::isBackEnabled() const
+{
+    return true;
+}
+
+bool
+OptionsQmlViewStep::isAtBeginning() const
+{
+    return true;
+}
+
+bool
+OptionsQmlViewStep::isAtEnd() const
+{
+    return true;
+}
+
+Calamares::JobList
+OptionsQmlViewStep::jobs() const
+{
+    return Calamares::JobList();
+}
+
+void
+OptionsQmlViewStep::onLeave()
+{
+    m_config.finalizeGlobalStorage();
+    m_config.saveSnapshot();
+}
+
+void
+OptionsQmlViewStep::nextIsReady()
+{
+    updateNextEnabled( true );
+}
+
+void
+OptionsQmlViewStep::updateNextEnabled( bool enabled )
+{
+    m_nextEnabled = enabled;
+    emit nextStatusChanged( enabled );
+}
+
+void
+OptionsQmlViewStep::setConfigurationMap( const QVariantMap& configurationMap )
+{
+    m_config.setConfigurationMap( configurationMap );
+    Calamares::QmlViewStep::setConfigurationMap( configurationMap );  // call parent implementation last
+}
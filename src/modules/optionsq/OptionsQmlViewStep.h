@@ -0,0 +1,63 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef OPTIONSQMLVIEWSTEP_H
+#define OPTIONSQMLVIEWSTEP_H
+
+#include "Config.h"
+
+#include "DllMacro.h"
+#include "utils/PluginFactory.h"
+#include "viewpages/QmlViewStep.h"
+
+#include <QVariant>
+
+/** @brief QML version of the options page
+ *
+ * Uses the same Config (and so the same OptionModel and sources)
+ * as OptionsViewStep; the QML shows the flattened list model from
+ * Config::optionList() in a ListView.
+ */
+class PLUGINDLLEXPORT OptionsQmlViewStep : public Calamares::QmlViewStep
+{
+    Q_OBJECT
+
+public:
+    explicit OptionsQmlViewStep( QObject* parent = nullptr );
+
+    QString prettyName() const override;
+
+    bool isNextEnabled() const override;
+    bool isBackEnabled() const override;
+
+    bool isAtBeginning() const override;
+    bool isAtEnd() const override;
+
+    Calamares::JobList jobs() const override;
+
+    // Leaving the page; store all selected options for later installation.
+    void onLeave() override;
+
+    void setConfigurationMap( const QVariantMap& configurationMap ) override;
+
+    QObject* getConfig() override { return &m_config; }
+
+public slots:
+    void nextIsReady();
+
+private:
+    void updateNextEnabled( bool enabled );
+
+    Config m_config;
+    bool m_nextEnabled = false;
+};
+
+CALAMARES_PLUGIN_FACTORY_DECLARATION( OptionsQmlViewStepFactory )
+
+#endif  // OPTIONSQMLVIEWSTEP_H
@@ -0,0 +1,114 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+import io.calamares.core 1.0
+import io.calamares.ui 1.0
+
+import QtQuick 2.15
+import QtQuick.Controls 2.15
+import QtQuick.Layouts 1.3
+
+Page {
+    width: 800
+    height: 400
+
+    ColumnLayout {
+        anchors.fill: parent
+        anchors.margins: 8
+        spacing: 6
+
+        Label {
+            Layout.fillWidth: true
+            horizontalAlignment: Text.AlignHCenter
+            text: config.titleLabel
+            visible: text !== ""
+        }
+
+        // Only the delegates in (and just around) the viewport exist;
+        // scrolled-out delegates are reused for rows scrolling in.
+        ListView {
+            id: optionList
+
+            Layout.fillWidth: true
+            Layout.fillHeight: true
+            clip: true
+            reuseItems: true
+            boundsBehavior: Flickable.StopAtBounds
+            model: config.optionList
+
+            ScrollBar.vertical: ScrollBar { }
+
+            delegate: Item {
+                width: ListView.view.width
+                height: row.implicitHeight + 4
+
+                RowLayout {
+                    id: row
+
+                    anchors.fill: parent
+                    anchors.leftMargin: model.depth * 20
+                    spacing: 4
+
+                    ToolButton {
+                        Layout.preferredWidth: 24
+                        text: model.expanded ? "▾" : "▸"
+                        enabled: model.hasChildren
+                        opacity: model.hasChildren ? 1.0 : 0.0
+                        onClicked: config.optionList.toggleExpanded(index)
+                    }
+
+                    CheckBox {
+                        id: check
+
+                        tristate: true
+                        visible: model.checkable
+                        checkState: model.checkState
+                        // The model decides the resulting state (distinct groups,
+                        // partial parents); a click only asks for on or off.
+                        nextCheckState: function() {
+                            return checkState === Qt.Checked ? Qt.Unchecked : Qt.Checked
+                        }
+                        onToggled: {
+                            config.optionList.setCheckState(index, checkState)
+                            checkState = Qt.binding(function() { return model.checkState })
+                        }
+                    }
+
+                    Label {
+                        Layout.preferredWidth: optionList.width / 3
+                        elide: Text.ElideRight
+                        text: model.name
+                        visible: !model.spacer
+                    }
+
+                    Label {
+                        Layout.fillWidth: true
+                        elide: Text.ElideRight
+                        opacity: 0.7
+                        text: model.description
+                    }
+
+                    TextField {
+                        Layout.preferredWidth: optionList.width / 5
+                        visible: model.editable
+                        text: model.input
+                        onEditingFinished: config.optionList.setInput(index, text)
+                    }
+                }
+            }
+        }
+
+        Label {
+            Layout.fillWidth: true
+            text: config.status
+            visible: text !== ""
+            wrapMode: Text.WordWrap
+        }
+    }
+}
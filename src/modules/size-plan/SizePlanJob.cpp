@@ -0,0 +1,338 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "SizePlanJob.h"
+
+#include "GlobalStorage.h"
+#include "JobQueue.h"
+#include "modulesystem/Module.h"
+#include "modulesystem/ModuleFactory.h"
+#include "modulesystem/ModuleManager.h"
+#include "utils/Logger.h"
+#include "utils/Variant.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStorageInfo>
+
+#include <memory>
+
+#include <sys/stat.h>
+
+static constexpr qint64 MiB = 1024 * 1024;
+static constexpr qint64 GiB = 1024 * MiB;
+
+/// @brief The largest file that FAT can hold
+static constexpr qint64 fatFileLimit = 4 * GiB - 1;
+
+namespace
+{
+/// @brief A file that the installation writes
+struct Item
+{
+    QString name;  ///< Relative to the root mount point
+    qint64 size = 0;  ///< Bytes, as the file appears
+    qint64 allocated = 0;  ///< Bytes taken from the free space, in whole blocks
+    qint64 written = 0;  ///< Bytes written to make it, what the time goes to
+};
+}  // namespace
+
+/// @brief @p path with @p slot added to the file name, as make-ab names it (system.img -> system_b.img)
+static QString
+slotPath( const QString& path, const char* slot )
+{
+    const QFileInfo fi( path );
+    const QString name = fi.fileName();
+    const int dot = name.lastIndexOf( '.' );
+    const QString suffix = QStringLiteral( "_" ) + QLatin1String( slot );
+    const QString slotName = dot > 0 ? name.left( dot ) + suffix + name.mid( dot ) : name + suffix;
+    return QDir::cleanPath( fi.dir().filePath( slotName ) );
+}
+
+static bool
+isFat( const QString& fsType )
+{
+    return fsType == QStringLiteral( "vfat" ) || fsType == QStringLiteral( "msdos" )
+        || fsType.startsWith( QStringLiteral( "fat" ) );
+}
+
+/// @brief Can @p fsType keep the holes of a sparse file? FAT-likes allocate them.
+static bool
+keepsHoles( const QString& fsType )
+{
+    return !isFat( fsType ) && fsType != QStringLiteral( "exfat" );
+}
+
+/// @brief Can make-ab populate a B slot on @p fsType by reflink, without using space?
+static bool
+canReflink( const QString& fsType )
+{
+    return fsType == QStringLiteral( "btrfs" ) || fsType == QStringLiteral( "xfs" )
+        || fsType == QStringLiteral( "bcachefs" );
+}
+
+/// @brief Can @p root tell "DATA" and "data" apart? Same check as gen-img.
+static bool
+isCaseSensitive( const QDir& root )
+{
+    if ( !root.mkdir( QStringLiteral( "DATA" ) ) )
+    {
+        return false;
+    }
+    root.rmdir( QStringLiteral( "DATA" ) );
+    return true;
+}
+
+/// @brief Bytes actually stored for @p path (holes excluded), or its size
+static qint64
+storedSize( const QString& path, qint64 size )
+{
+    struct stat st;
+    if ( ::stat( QFile::encodeName( path ).constData(), &st ) != 0 )
+    {
+        return size;
+    }
+    return qMin( size, qint64( st.st_blocks ) * 512 );
+}
+
+/// @brief The configuration of module @p name, from @p configFile, as the module itself would load it
+static QVariantMap
+moduleConfiguration( const QString& name, const QString& configFile )
+{
+    auto* manager = Calamares::ModuleManager::instance();
+    const auto descriptor = manager ? manager->moduleDescriptor( name ) : Calamares::ModuleSystem::Descriptor();
+    if ( !descriptor.isValid() )
+    {
+        cWarning() << "size-plan cannot find module" << name << "- its files are not planned for.";
+        return {};
+    }
+    std::unique_ptr< Calamares::Module > module(
+        Calamares::moduleFromDescriptor( descriptor, name, configFile, descriptor.directory() ) );
+    return module ? module->configurationMap() : QVariantMap();
+}
+
+SizePlanJob::SizePlanJob( QObject* parent )
+    : Calamares::CppJob( parent )
+{
+}
+
+SizePlanJob::~SizePlanJob() {}
+
+QString
+SizePlanJob::prettyName() const
+{
+    return tr( "Checking the space for the installation." );
+}
+
+Calamares::JobResult
+SizePlanJob::exec()
+{
+    auto* gs = Calamares::JobQueue::instance()->globalStorage();
+    const QString rootPath = gs ? gs->value( "rootMountPoint" ).toString() : QString();
+    if ( rootPath.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "No mount point for root partition" ),
+                                            tr( "globalstorage does not contain a \"rootMountPoint\" key." ) );
+    }
+    const QDir root( rootPath );
+    QStorageInfo storage( rootPath );
+    if ( !root.exists() || !storage.isValid() || !storage.isReady() )
+    {
+        return Calamares::JobResult::error( tr( "Bad mount point for root partition" ),
+                                            tr( "rootMountPoint is \"%1\", which does not exist." ).arg( rootPath ) );
+    }
+
+    const QString fsType = QString::fromLatin1( storage.fileSystemType() );
+    const qint64 block = qMax( 512, storage.blockSize() );
+    auto inBlocks = [ block ]( qint64 bytes ) { return ( bytes + block - 1 ) / block * block; };
+    qint64 available = storage.bytesAvailable();
+
+    QStringList problems;
+    QList< Item > items;
+    QHash< QString, qint64 > copied;  ///< Sizes of the copied images, by name
+    for ( const auto& image : std::as_const( m_images ) )
+    {
+        const QFileInfo source( image.source );
+        if ( !source.isFile() )
+        {
+            problems.append( tr( "The source file \"%1\" does not exist." ).arg( image.source ) );
+            continue;
+        }
+        QString name = QDir::cleanPath( image.destination.mid( image.destination.startsWith( '/' ) ? 1 : 0 ) );
+        if ( image.destination.endsWith( '/' ) || QFileInfo( root.filePath( name ) ).isDir() )
+        {
+            name = QDir( name ).filePath( source.fileName() );
+        }
+
+        // A file from an earlier installation is replaced, which frees its space
+        const QFileInfo existing( root.filePath( name ) );
+        if ( existing.isFile() )
+        {
+            available += inBlocks( storedSize( existing.filePath(), existing.size() ) );
+        }
+
+        const qint64 stored = keepsHoles( fsType ) ? storedSize( image.source, source.size() ) : source.size();
+        items.append( { name, source.size(), inBlocks( stored ), stored } );
+        copied.insert( name, source.size() );
+    }
+
+    for ( const auto& slot : std::as_const( m_slots ) )
+    {
+        const QString file = QDir::cleanPath( slot.file );
+        const qint64 size = slot.size >= 0 ? slot.size : copied.value( file, -1 );
+        if ( size < 0 )
+        {
+            problems.append( tr( "The B slot of \"%1\" takes the size of a file that is not copied." ).arg( file ) );
+            continue;
+        }
+        const bool shared = ( slot.populate && canReflink( fsType ) ) || ( !m_preallocate && keepsHoles( fsType ) );
+        // make-ab reflinks or starts the slot empty, never copies; only
+        // filesystems that cannot keep holes zero the blocks to make it
+        const bool writes = !keepsHoles( fsType );
+        items.append( { slotPath( file, "b" ), size, shared ? 0 : inBlocks( size ), writes ? size : 0 } );
+    }
+    items.append( { QStringLiteral( "misc.img" ), m_miscSize, inBlocks( m_miscSize ), m_miscSize } );
+
+    for ( const auto& item : std::as_const( items ) )
+    {
+        if ( isFat( fsType ) && item.size > fatFileLimit )
+        {
+            problems.append( tr( "\"%1\" is %2 MiB, but a file on %3 can be at most 4 GiB." )
+                                 .arg( item.name )
+                                 .arg( item.size / MiB )
+                                 .arg( fsType ) );
+        }
+    }
+
+    qint64 needed = 0;
+    for ( const auto& item : std::as_const( items ) )
+    {
+        needed += item.allocated;
+    }
+    const int overhead = m_overhead.value( fsType, m_overhead.value( QStringLiteral( "default" ), 0 ) );
+    needed += needed * overhead / 100;
+
+    const bool dataImage
+        = gs->value( "options" ).toString().split( ' ' ).contains( m_dataOption ) || !isCaseSensitive( root );
+    qint64 dataSize = ( available - needed - ( dataImage ? m_dataReserve : 0 ) ) / MiB * MiB;
+    if ( dataImage && isFat( fsType ) )
+    {
+        dataSize = qMin( dataSize, fatFileLimit / MiB * MiB );
+    }
+    if ( dataSize < m_minDataSize )
+    {
+        problems.append( tr( "The system needs %1 MiB and the data at least %2 MiB, but only %3 MiB are free." )
+                             .arg( needed / MiB )
+                             .arg( ( m_minDataSize + ( dataImage ? m_dataReserve : 0 ) ) / MiB )
+                             .arg( available / MiB ) );
+    }
+
+    cDebug() << "Installation plan on" << fsType << "block" << block << "free" << available / MiB << "MiB";
+    for ( const auto& item : std::as_const( items ) )
+    {
+        cDebug() << Logger::SubEntry << item.name << item.size / MiB << "MiB, allocates" << item.allocated / MiB
+                 << "MiB";
+    }
+    cDebug() << Logger::SubEntry << "overhead" << overhead << "%, data" << ( dataImage ? "image" : "directory" )
+             << dataSize / MiB << "MiB";
+
+    // data.img is zeroed where it cannot be preallocated, like the B slots
+    qint64 volume = dataImage && !keepsHoles( fsType ) ? dataSize : 0;
+    for ( const auto& item : std::as_const( items ) )
+    {
+        volume += item.written;
+    }
+    cDebug() << Logger::SubEntry << "writes" << volume / MiB << "MiB";
+
+    if ( !problems.isEmpty() )
+    {
+        for ( const auto& problem : std::as_const( problems ) )
+        {
+            cWarning() << problem;
+        }
+        return Calamares::JobResult::error( tr( "The installation does not fit on the target" ),
+                                            problems.join( '\n' ) );
+    }
+
+    QVariantMap files;
+    for ( const auto& item : std::as_const( items ) )
+    {
+        files.insert( item.name, item.size );
+    }
+    gs->insert( "installPlan",
+                QVariantMap { { "filesystem", fsType },
+                              { "available", available },
+                              { "needed", needed },
+                              { "files", files },
+                              { "dataImage", dataImage },
+                              { "dataSize", dataSize },
+                              { "volume", volume } } );
+
+    emit progress( 1.0 );
+    return Calamares::JobResult::ok();
+}
+
+void
+SizePlanJob::setConfigurationMap( const QVariantMap& configurationMap )
+{
+    m_minDataSize = Calamares::getInteger( configurationMap, "minDataSize", 2048 ) * MiB;
+    m_overhead.clear();
+    const QVariantMap overhead = configurationMap.value( "overhead" ).toMap();
+    for ( auto it = overhead.cbegin(); it != overhead.cend(); ++it )
+    {
+        m_overhead.insert( it.key(), qBound( 0, it.value().toInt(), 100 ) );
+    }
+
+    const QVariantMap modules = configurationMap.value( "modules" ).toMap();
+    auto configOf = [ &modules ]( const QString& name )
+    {
+        const QString configFile = Calamares::getString( modules, name, QStringLiteral( "%1.conf" ).arg( name ) );
+        return moduleConfiguration( name, configFile );
+    };
+
+    m_images.clear();
+    for ( const auto& v : configOf( QStringLiteral( "unpackfile" ) ).value( "unpack" ).toList() )
+    {
+        const QVariantMap map = v.toMap();
+        m_images.append( { Calamares::getString( map, "source" ), Calamares::getString( map, "destination" ) } );
+    }
+
+    const QVariantMap makeAb = configOf( QStringLiteral( "make-ab" ) );
+    m_preallocate = Calamares::getBool( makeAb, "preallocate", true );
+    m_slots.clear();
+    for ( const auto& v : makeAb.value( "make-ab" ).toList() )
+    {
+        const QVariantMap map = v.toMap();
+        Slot slot;
+        slot.file = Calamares::getString( map, "file" );
+        slot.populate = Calamares::getBool( map, "populate", false );
+        if ( map.contains( "size" ) && map.value( "size" ).toString() != QStringLiteral( "auto" ) )
+        {
+            slot.size = Calamares::getInteger( map, "size", 0 ) * MiB;
+        }
+        if ( !slot.file.isEmpty() )
+        {
+            m_slots.append( slot );
+        }
+    }
+
+    // The defaults are those of gen-img
+    const QVariantMap genImg = configOf( QStringLiteral( "gen-img" ) );
+    m_miscSize = Calamares::getInteger( genImg, "miscSize", 10 ) * MiB;
+    m_dataReserve = Calamares::getInteger( genImg, "dataReserve", 4096 ) * MiB;
+    m_dataOption = Calamares::getString( genImg, "dataOption", QStringLiteral( "DATA=data.img" ) );
+
+    if ( m_images.isEmpty() )
+    {
+        cWarning() << "size-plan found no files that unpackfile copies.";
+    }
+}
+
+CALAMARES_PLUGIN_FACTORY_DEFINITION( SizePlanJobFactory, registerPlugin< SizePlanJob >(); )
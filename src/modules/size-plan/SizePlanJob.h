@@ -0,0 +1,75 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef SIZEPLANJOB_H
+#define SIZEPLANJOB_H
+
+#include "CppJob.h"
+#include "DllMacro.h"
+#include "utils/PluginFactory.h"
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QVariantMap>
+
+/** @brief Checks that the installation fits, before anything is copied
+ *
+ * The sizes come from the configuration of the modules that write to
+ * the target: the images that unpackfile copies, the B slots of
+ * make-ab, and misc.img and data.img of gen-img. Each file is rounded
+ * up to the block size of the target filesystem, and checked against
+ * its limits (4 GiB per file on FAT). When the files, the data image
+ * (or data directory) and the overhead of the filesystem do not fit,
+ * the job fails with the numbers, before gigabytes are copied.
+ *
+ * The plan is stored in GlobalStorage as *installPlan*; gen-img takes
+ * the size of data.img from it.
+ */
+class PLUGINDLLEXPORT SizePlanJob : public Calamares::CppJob
+{
+    Q_OBJECT
+
+public:
+    explicit SizePlanJob( QObject* parent = nullptr );
+    ~SizePlanJob() override;
+
+    QString prettyName() const override;
+
+    Calamares::JobResult exec() override;
+
+    void setConfigurationMap( const QVariantMap& configurationMap ) override;
+
+private:
+    struct Image
+    {
+        QString source;
+        QString destination;  ///< As configured for unpackfile
+    };
+    struct Slot
+    {
+        QString file;  ///< Relative to the root mount point
+        qint64 size = -1;  ///< In bytes; -1 for "same as the A slot"
+        bool populate = false;
+    };
+
+    QList< Image > m_images;
+    QList< Slot > m_slots;
+    bool m_preallocate = true;
+    qint64 m_miscSize = 0;  ///< Bytes
+    qint64 m_dataReserve = 0;  ///< Bytes
+    QString m_dataOption;
+
+    qint64 m_minDataSize = 0;  ///< Bytes, for data.img or the data directory
+    QHash< QString, int > m_overhead;  ///< Percent, by filesystem type
+};
+
+CALAMARES_PLUGIN_FACTORY_DECLARATION( SizePlanJobFactory )
+
+#endif  // SIZEPLANJOB_H
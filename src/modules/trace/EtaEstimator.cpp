@@ -0,0 +1,124 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "EtaEstimator.h"
+
+#include "GlobalStorage.h"
+#include "JobQueue.h"
+#include "utils/Logger.h"
+
+#include <QVariantMap>
+
+#include <cmath>
+
+static constexpr qint64 MiB = 1024 * 1024;
+static constexpr int interval = 1000;  ///< ms between updates
+/// @brief ms of writing before there is an estimate, so that the first burst into the page cache does not count
+static constexpr qint64 warmUp = 3000;
+/// @brief Time constant of the smoothing of the rate, in seconds
+static constexpr double smoothing = 10.0;
+
+static Calamares::GlobalStorage*
+globalStorage()
+{
+    auto* queue = Calamares::JobQueue::instance();
+    return queue ? queue->globalStorage() : nullptr;
+}
+
+EtaEstimator::EtaEstimator( QObject* parent )
+    : QObject( parent )
+{
+    m_timer.setInterval( interval );
+    connect( &m_timer, &QTimer::timeout, this, &EtaEstimator::update );
+}
+
+EtaEstimator::~EtaEstimator() {}
+
+void
+EtaEstimator::start()
+{
+    if ( !m_timer.isActive() )
+    {
+        m_timer.start();
+    }
+}
+
+void
+EtaEstimator::stop( bool done )
+{
+    m_timer.stop();
+    auto* gs = globalStorage();
+    if ( done && gs && m_volume >= 0 )
+    {
+        gs->insert( "installEta",
+                    QVariantMap { { "seconds", 0 },
+                                  { "progress", 1.0 },
+                                  { "written", m_volume },
+                                  { "volume", m_volume },
+                                  { "rate", m_rate } } );
+    }
+    if ( m_volume > 0 )
+    {
+        cDebug() << "Wrote" << m_written / MiB << "MiB of the planned" << m_volume / MiB << "MiB in"
+                 << m_clock.elapsed() / 1000 << "s";
+    }
+}
+
+void
+EtaEstimator::update()
+{
+    auto* gs = globalStorage();
+    if ( !gs )
+    {
+        return;
+    }
+    if ( m_volume < 0 )
+    {
+        // The plan is made early in the exec phase, before the images are written
+        const QVariantMap plan = gs->value( "installPlan" ).toMap();
+        if ( !plan.contains( "volume" ) )
+        {
+            return;
+        }
+        m_volume = plan.value( "volume" ).toLongLong();
+        m_base = m_meter.sample().writeBytes;
+        m_clock.start();
+        cDebug() << "Estimating the install time for" << m_volume / MiB << "MiB of writes";
+    }
+
+    const qint64 now = m_clock.elapsed();
+    const qint64 written = qMax( qint64( 0 ), m_meter.sample().writeBytes - m_base );
+    const double seconds = double( now - m_lastUpdate ) / 1000;
+    if ( seconds > 0 )
+    {
+        const double rate = double( written - m_written ) / seconds;
+        const double weight = 1.0 - std::exp( -seconds / smoothing );
+        m_rate = m_rate > 0 ? m_rate + weight * ( rate - m_rate ) : rate;
+    }
+    m_written = written;
+    m_lastUpdate = now;
+
+    const qint64 done = qMin( written, m_volume );
+    const qint64 left = m_volume - done;
+    qint64 eta = -1;
+    if ( left == 0 )
+    {
+        eta = 0;
+    }
+    else if ( now >= warmUp && m_rate > 0 )
+    {
+        eta = qint64( std::ceil( double( left ) / m_rate ) );
+    }
+    gs->insert( "installEta",
+                QVariantMap { { "seconds", eta },
+                              { "progress", m_volume > 0 ? double( done ) / m_volume : 1.0 },
+                              { "written", done },
+                              { "volume", m_volume },
+                              { "rate", m_rate } } );
+}
@@ -0,0 +1,59 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef TRACE_ETAESTIMATOR_H
+#define TRACE_ETAESTIMATOR_H
+
+#include "ResourceMeter.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+/** @brief Estimates the time left for the exec phase from the bytes it writes
+ *
+ * The progress of the job queue weighs every module the same, while
+ * nearly all of the time goes to writing the images. size-plan knows
+ * how many bytes the installation writes (*volume* of *installPlan*,
+ * after reflinks, holes and preallocation); this compares that with
+ * what the installer has written since (see ResourceMeter), and with
+ * the recent write rate, once a second.
+ *
+ * The estimate goes to GlobalStorage as *installEta*, for the
+ * slideshow: *seconds* left (-1 while there is no estimate yet),
+ * *progress* (0 to 1) of the bytes, *written* and *volume* in bytes,
+ * and *rate* in bytes per second.
+ */
+class EtaEstimator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EtaEstimator( QObject* parent = nullptr );
+    ~EtaEstimator() override;
+
+    /// @brief Starts estimating, when the job queue starts; again does nothing
+    void start();
+    /// @brief Stops estimating; @p done says that nothing is left
+    void stop( bool done );
+
+private:
+    void update();
+
+    ResourceMeter m_meter;
+    QTimer m_timer;
+    QElapsedTimer m_clock;  ///< Since the plan was seen
+    qint64 m_volume = -1;  ///< Bytes that the plan writes, -1 until there is a plan
+    qint64 m_base = 0;  ///< Bytes written before the plan
+    qint64 m_written = 0;  ///< Bytes written since, at the last update
+    qint64 m_lastUpdate = 0;  ///< m_clock at the last update, ms
+    double m_rate = 0.0;  ///< Bytes per second, smoothed
+};
+
+#endif  // TRACE_ETAESTIMATOR_H
@@ -0,0 +1,174 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "ResourceMeter.h"
+
+#include "utils/Logger.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+
+#include <sys/resource.h>
+
+static QList< QByteArray >
+readLines( const QString& path )
+{
+    QFile file( path );
+    return file.open( QIODevice::ReadOnly ) ? file.readAll().split( '\n' ) : QList< QByteArray >();
+}
+
+static bool
+writeFile( const QString& path, const QByteArray& data )
+{
+    QFile file( path );
+    return file.open( QIODevice::WriteOnly ) && file.write( data ) == data.size();
+}
+
+/// @brief The number after @p key in lines like "key: 123" or "key 123"
+static qint64
+fieldValue( const QList< QByteArray >& lines, const QByteArray& key )
+{
+    for ( const QByteArray& line : lines )
+    {
+        if ( line.startsWith( key ) )
+        {
+            return line.mid( key.size() ).trimmed().split( ' ' ).value( 0 ).toLongLong();
+        }
+    }
+    return 0;
+}
+
+static qint64
+microseconds( const struct timeval& t )
+{
+    return qint64( t.tv_sec ) * 1000000 + t.tv_usec;
+}
+
+ResourceMeter::ResourceMeter()
+{
+    QString path;
+    for ( const QByteArray& line : readLines( QStringLiteral( "/proc/self/cgroup" ) ) )
+    {
+        if ( line.startsWith( "0::" ) )
+        {
+            path = QString::fromUtf8( line.mid( 3 ) );
+        }
+    }
+    if ( path.isEmpty() )
+    {
+        cDebug() << "No cgroup v2; resources are from /proc.";
+        return;
+    }
+
+    const QDir base( QStringLiteral( "/sys/fs/cgroup" ) + path );
+    const QString name = QStringLiteral( "calamares-install" );
+    if ( base.dirName() == name )
+    {
+        m_cgroup = base.path();
+    }
+    else if ( base.mkpath( name )
+              && writeFile( base.filePath( name + QStringLiteral( "/cgroup.procs" ) ),
+                            QByteArray::number( QCoreApplication::applicationPid() ) ) )
+    {
+        m_cgroup = base.filePath( name );
+        // Only works when nothing else is left in the parent; otherwise there is no io.stat
+        writeFile( base.filePath( QStringLiteral( "cgroup.subtree_control" ) ), "+io" );
+    }
+    else
+    {
+        cDebug() << "Cannot make cgroup" << base.filePath( name ) << "; resources are from /proc.";
+        return;
+    }
+    m_ioStat = QFileInfo::exists( QDir( m_cgroup ).filePath( QStringLiteral( "io.stat" ) ) );
+    cDebug() << "Resources are measured in cgroup" << m_cgroup << ( m_ioStat ? "with" : "without" ) << "io.stat";
+}
+
+ResourceMeter::ResourceMeter( const QString& cgroup )
+    : m_cgroup( cgroup )
+    , m_ioStat( !cgroup.isEmpty() && QFileInfo::exists( QDir( cgroup ).filePath( QStringLiteral( "io.stat" ) ) ) )
+{
+}
+
+ResourceUsage
+ResourceMeter::sample() const
+{
+    ResourceUsage usage;
+
+    struct rusage self;
+    struct rusage children;
+    const bool haveSelf = ::getrusage( RUSAGE_SELF, &self ) == 0;
+    const bool haveChildren = ::getrusage( RUSAGE_CHILDREN, &children ) == 0;
+    if ( !m_cgroup.isEmpty() )
+    {
+        usage.cpu = fieldValue( readLines( QDir( m_cgroup ).filePath( QStringLiteral( "cpu.stat" ) ) ), "usage_usec" );
+    }
+    else
+    {
+        usage.cpu = ( haveSelf ? microseconds( self.ru_utime ) + microseconds( self.ru_stime ) : 0 )
+            + ( haveChildren ? microseconds( children.ru_utime ) + microseconds( children.ru_stime ) : 0 );
+    }
+    usage.childrenPeakRss = haveChildren ? qint64( children.ru_maxrss ) * 1024 : 0;
+
+    if ( m_ioStat )
+    {
+        // 8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0, per device
+        for ( const QByteArray& line : readLines( QDir( m_cgroup ).filePath( QStringLiteral( "io.stat" ) ) ) )
+        {
+            for ( const QByteArray& field : line.split( ' ' ) )
+            {
+                if ( field.startsWith( "rbytes=" ) )
+                {
+                    usage.readBytes += field.mid( 7 ).toLongLong();
+                }
+                else if ( field.startsWith( "wbytes=" ) )
+                {
+                    usage.writeBytes += field.mid( 7 ).toLongLong();
+                }
+            }
+        }
+    }
+    else
+    {
+        const auto io = readLines( QStringLiteral( "/proc/self/io" ) );
+        usage.readBytes = fieldValue( io, "read_bytes:" );
+        usage.writeBytes = fieldValue( io, "write_bytes:" );
+    }
+
+    usage.peakRss = fieldValue( readLines( QStringLiteral( "/proc/self/status" ) ), "VmHWM:" ) * 1024;
+    return usage;
+}
+
+void
+ResourceMeter::resetPeak()
+{
+    // "5" resets the peak RSS (VmHWM) of the process
+    writeFile( QStringLiteral( "/proc/self/clear_refs" ), "5" );
+}
+
+QJsonObject
+ResourceMeter::sources() const
+{
+    return QJsonObject { { "cpu", m_cgroup.isEmpty() ? "proc" : "cgroup" }, { "io", m_ioStat ? "cgroup" : "proc" } };
+}
+
+QJsonObject
+ResourceMeter::difference( const ResourceUsage& from, const ResourceUsage& to )
+{
+    return QJsonObject {
+        { "cpuMs", ( to.cpu - from.cpu ) / 1000 },
+        { "readBytes", to.readBytes - from.readBytes },
+        { "writeBytes", to.writeBytes - from.writeBytes },
+        { "peakRss", to.peakRss },
+        // Only a child that finished during the job, and was the largest so far, shows up
+        { "childrenPeakRss", to.childrenPeakRss > from.childrenPeakRss ? to.childrenPeakRss : 0 },
+    };
+}
@@ -0,0 +1,66 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef TRACE_RESOURCEMETER_H
+#define TRACE_RESOURCEMETER_H
+
+#include <QJsonObject>
+#include <QString>
+
+/// @brief Resources used so far by the installer, with its child processes where possible
+struct ResourceUsage
+{
+    qint64 cpu = 0;  ///< Microseconds, user and system
+    qint64 readBytes = 0;  ///< From storage
+    qint64 writeBytes = 0;  ///< To storage
+    qint64 peakRss = 0;  ///< Bytes, of the installer itself, since ResourceMeter::resetPeak()
+    qint64 childrenPeakRss = 0;  ///< Bytes, the largest child process that has finished
+};
+
+/** @brief Measures what the installer uses, for each job
+ *
+ * Jobs are threads of one process, so they cannot each have a cgroup.
+ * Instead, the installer moves itself into a cgroup v2 subgroup of its
+ * own (calamares-install), which its child processes inherit; CPU time
+ * and storage I/O come from cpu.stat and io.stat there, and include
+ * the commands the Python modules run. Where that cannot be done (no
+ * cgroup v2, no rights, no io controller), they come from
+ * /proc/self/io and getrusage(), which count finished children's CPU
+ * time but not their I/O.
+ *
+ * The peak RSS is that of the installer (VmHWM, which resetPeak()
+ * resets through clear_refs), so that each job gets its own peak.
+ *
+ * The trace module makes the subgroup, and names it in the environment
+ * as CALAMARES_TRACE_CGROUP, for other modules (jobgraph) to measure in.
+ */
+class ResourceMeter
+{
+public:
+    ResourceMeter();
+    /// @brief Measures in the subgroup @p cgroup that another meter made; from /proc when it is empty
+    explicit ResourceMeter( const QString& cgroup );
+
+    ResourceUsage sample() const;
+    void resetPeak();
+
+    /// @brief Where the CPU time and the I/O come from: "cgroup" or "proc"
+    QJsonObject sources() const;
+    /// @brief Directory of the subgroup, or empty
+    QString cgroup() const { return m_cgroup; }
+
+    /// @brief The usage between @p from and @p to, for the report
+    static QJsonObject difference( const ResourceUsage& from, const ResourceUsage& to );
+
+private:
+    QString m_cgroup;  ///< Directory of the subgroup, or empty
+    bool m_ioStat = false;  ///< The io controller is on in m_cgroup
+};
+
+#endif  // TRACE_RESOURCEMETER_H
@@ -0,0 +1,347 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "TraceJob.h"
+
+#include "TraceSpool.h"
+
+#include "JobQueue.h"
+#include "ViewManager.h"
+#include "modulesystem/ModuleManager.h"
+#include "utils/Logger.h"
+#include "utils/Variant.h"
+#include "viewpages/ViewStep.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QMetaObject>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QThread>
+
+/// @brief Pseudo-threads of the trace, for what happens on the UI thread
+static constexpr int pagesThread = 1;
+static constexpr int queueThread = 2;
+
+/// @brief The value of @p key in a "key : value" file like /proc/cpuinfo
+static QString
+procValue( const QString& path, const QByteArray& key )
+{
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        return QString();
+    }
+    for ( const QByteArray& line : file.readAll().split( '\n' ) )
+    {
+        const int colon = line.indexOf( ':' );
+        if ( colon > 0 && line.left( colon ).trimmed() == key )
+        {
+            return QString::fromUtf8( line.mid( colon + 1 ).trimmed() );
+        }
+    }
+    return QString();
+}
+
+static QString
+readLine( const QString& path )
+{
+    QFile file( path );
+    return file.open( QIODevice::ReadOnly ) ? QString::fromUtf8( file.readLine() ).trimmed() : QString();
+}
+
+/// @brief What installs are compared by
+static QJsonObject
+hostInfo()
+{
+    return QJsonObject {
+        { "kernel", QSysInfo::kernelVersion() },
+        { "system", QSysInfo::prettyProductName() },
+        { "machine",
+          QStringLiteral( "%1 %2" ).arg( readLine( QStringLiteral( "/sys/class/dmi/id/sys_vendor" ) ),
+                                         readLine( QStringLiteral( "/sys/class/dmi/id/product_name" ) ) ) },
+        { "cpu", procValue( QStringLiteral( "/proc/cpuinfo" ), "model name" ) },
+        { "cpus", QThread::idealThreadCount() },
+        { "memory", procValue( QStringLiteral( "/proc/meminfo" ), "MemTotal" ) },
+    };
+}
+
+TraceJob::TraceJob( QObject* parent )
+    : Calamares::CppJob( parent )
+{
+}
+
+TraceJob::~TraceJob() {}
+
+QString
+TraceJob::prettyName() const
+{
+    return tr( "Saving the installation timeline." );
+}
+
+void
+TraceJob::append( QJsonObject event, int thread )
+{
+    if ( m_spool.isEmpty() )
+    {
+        return;
+    }
+    event.insert( "pid", QCoreApplication::applicationPid() );
+    event.insert( "tid", thread );
+    if ( !event.contains( "ts" ) )
+    {
+        event.insert( "ts", TraceSpool::clock() );
+    }
+    TraceSpool::append( m_spool, event );
+}
+
+void
+TraceJob::begin( int thread, const QString& name, const char* category, const QJsonObject& args )
+{
+    append( { { "name", name }, { "cat", category }, { "ph", "B" }, { "args", args } }, thread );
+}
+
+void
+TraceJob::end( int thread, const QJsonObject& args )
+{
+    append( { { "ph", "E" }, { "args", args } }, thread );
+}
+
+void
+TraceJob::stepChanged()
+{
+    auto* step = Calamares::ViewManager::instance() ? Calamares::ViewManager::instance()->currentStep() : nullptr;
+    const QString name = step ? step->prettyName() : QString();
+    if ( name == m_step )
+    {
+        return;
+    }
+    if ( !m_step.isEmpty() )
+    {
+        end( pagesThread );
+    }
+    m_step = name;
+    if ( step )
+    {
+        begin( pagesThread, name, "page", { { "module", step->moduleInstanceKey().toString() } } );
+    }
+}
+
+void
+TraceJob::queueChanged( const QStringList& jobNames )
+{
+    m_queue = jobNames;
+    if ( m_job.isEmpty() )
+    {
+        m_jobIndex = -1;
+    }
+}
+
+void
+TraceJob::jobProgress( qreal percent, const QString& message )
+{
+    // The queue reports the status message of the job that runs, which
+    // changes as the job goes on. Only the name of a later job in the
+    // queue starts a new span; without the queue, any change does.
+    QString name = message;
+    if ( !m_queue.isEmpty() )
+    {
+        const int index = m_queue.indexOf( message, m_jobIndex + 1 );
+        if ( index < 0 && !m_job.isEmpty() )
+        {
+            return;
+        }
+        if ( index >= 0 )
+        {
+            m_jobIndex = index;
+            name = m_queue.at( index );
+        }
+    }
+    else if ( message == m_job )
+    {
+        return;
+    }
+    jobDone();
+    m_job = name;
+    m_jobStart = TraceSpool::clock();
+    if ( m_meter )
+    {
+        m_meter->resetPeak();
+        m_jobUsage = m_meter->sample();
+    }
+    begin( queueThread, name, "job", { { "percent", percent } } );
+}
+
+void
+TraceJob::jobDone( const QJsonObject& args )
+{
+    if ( m_job.isEmpty() )
+    {
+        return;
+    }
+    QJsonObject usage = m_meter ? ResourceMeter::difference( m_jobUsage, m_meter->sample() ) : QJsonObject();
+    for ( auto it = args.constBegin(); it != args.constEnd(); ++it )
+    {
+        usage.insert( it.key(), it.value() );
+    }
+    end( queueThread, usage );
+
+    usage.insert( "name", m_job );
+    usage.insert( "wallMs", ( TraceSpool::clock() - m_jobStart ) / 1000 );
+    m_jobs.append( usage );
+    m_job.clear();
+}
+
+void
+TraceJob::queueDone()
+{
+    const QJsonObject args
+        = m_failed ? QJsonObject { { "ok", false }, { "error", m_failure } } : QJsonObject { { "ok", true } };
+    if ( m_eta )
+    {
+        m_eta->stop( !m_failed );
+    }
+    jobDone( args );
+    append( { { "name", "done" }, { "cat", "job" }, { "ph", "i" }, { "s", "g" }, { "args", args } }, queueThread );
+    save();
+}
+
+void
+TraceJob::save()
+{
+    QFile spool( m_spool );
+    if ( m_spool.isEmpty() || !spool.open( QIODevice::ReadOnly ) )
+    {
+        return;
+    }
+    QJsonArray events;
+    QJsonArray modules;
+    for ( const QByteArray& line : spool.readAll().split( '\n' ) )
+    {
+        const QJsonObject event = QJsonDocument::fromJson( line ).object();
+        if ( event.isEmpty() )
+        {
+            continue;
+        }
+        events.append( event );
+        if ( event.value( "cat" ).toString() == QStringLiteral( "module" ) )
+        {
+            QJsonObject module = event.value( "args" ).toObject();
+            module.insert( "name", event.value( "name" ) );
+            module.insert( "wallMs", event.value( "dur" ).toDouble() / 1000 );
+            modules.append( module );
+        }
+    }
+
+    const QJsonObject host = hostInfo();
+    auto saveJson = []( const QString& path, const QJsonObject& content )
+    {
+        QSaveFile file( path );
+        if ( !file.open( QIODevice::WriteOnly ) || file.write( QJsonDocument( content ).toJson() ) < 0
+             || !file.commit() )
+        {
+            cWarning() << "Cannot write" << path << file.errorString();
+            return false;
+        }
+        return true;
+    };
+    if ( saveJson( m_output, { { "traceEvents", events }, { "displayTimeUnit", "ms" }, { "otherData", host } } ) )
+    {
+        cDebug() << "Install trace of" << events.count() << "events in" << m_output;
+    }
+    saveJson( m_report,
+              { { "host", host },
+                { "sources", m_meter ? m_meter->sources() : QJsonObject() },
+                { "jobs", m_jobs },
+                { "modules", modules } } );
+}
+
+Calamares::JobResult
+TraceJob::exec()
+{
+    // The spans and the report belong to the UI thread
+    QMetaObject::invokeMethod( this, [ this ]() { save(); }, Qt::BlockingQueuedConnection );
+    emit progress( 1.0 );
+    return Calamares::JobResult::ok();
+}
+
+void
+TraceJob::setConfigurationMap( const QVariantMap& configurationMap )
+{
+    if ( !m_spool.isEmpty() || !Calamares::getBool( configurationMap, "enabled", true ) )
+    {
+        return;
+    }
+
+    const QDir logDirectory = QFileInfo( Logger::logFile() ).dir();
+    m_spool = logDirectory.filePath( QStringLiteral( "session.trace.jsonl" ) );
+    m_output = logDirectory.filePath(
+        Calamares::getString( configurationMap, "output", QStringLiteral( "session.trace.json" ) ) );
+    m_report = logDirectory.filePath(
+        Calamares::getString( configurationMap, "report", QStringLiteral( "session.report.json" ) ) );
+    QFile::remove( m_spool );
+    qputenv( "CALAMARES_TRACE", QFile::encodeName( m_spool ) );
+
+    append( { { "name", "process_name" }, { "ph", "M" }, { "args", QJsonObject { { "name", "Calamares" } } } },
+            pagesThread );
+    append( { { "name", "thread_name" }, { "ph", "M" }, { "args", QJsonObject { { "name", "Pages" } } } },
+            pagesThread );
+    append( { { "name", "thread_name" }, { "ph", "M" }, { "args", QJsonObject { { "name", "Job queue" } } } },
+            queueThread );
+    append( { { "name", "start" }, { "cat", "page" }, { "ph", "i" }, { "s", "g" } }, pagesThread );
+    if ( Calamares::getBool( configurationMap, "resources", true ) )
+    {
+        m_meter = std::make_unique< ResourceMeter >();
+        qputenv( "CALAMARES_TRACE_CGROUP", QFile::encodeName( m_meter->cgroup() ) );
+    }
+    if ( Calamares::getBool( configurationMap, "eta", true ) )
+    {
+        m_eta = std::make_unique< EtaEstimator >();
+    }
+
+    // The pages exist once all the modules are loaded
+    if ( auto* manager = Calamares::ModuleManager::instance() )
+    {
+        connect( manager,
+                 &Calamares::ModuleManager::modulesLoaded,
+                 this,
+                 [ this ]()
+                 {
+                     if ( auto* views = Calamares::ViewManager::instance() )
+                     {
+                         connect( views, &Calamares::ViewManager::currentStepChanged, this, &TraceJob::stepChanged );
+                         stepChanged();
+                     }
+                 } );
+    }
+    if ( auto* queue = Calamares::JobQueue::instance() )
+    {
+        connect( queue, &Calamares::JobQueue::queueChanged, this, &TraceJob::queueChanged );
+        connect( queue, &Calamares::JobQueue::progress, this, &TraceJob::jobProgress );
+        // The queue also finishes after it fails, so the failure is kept for then
+        connect( queue, &Calamares::JobQueue::finished, this, &TraceJob::queueDone );
+        connect( queue,
+                 &Calamares::JobQueue::failed,
+                 this,
+                 [ this ]( const QString& message, const QString& )
+                 {
+                     m_failed = true;
+                     m_failure = message;
+                 } );
+        if ( m_eta )
+        {
+            connect( queue, &Calamares::JobQueue::progress, m_eta.get(), &EtaEstimator::start );
+        }
+    }
+}
+
+CALAMARES_PLUGIN_FACTORY_DEFINITION( TraceJobFactory, registerPlugin< TraceJob >(); )
@@ -0,0 +1,96 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef TRACEJOB_H
+#define TRACEJOB_H
+
+#include "EtaEstimator.h"
+#include "ResourceMeter.h"
+
+#include "CppJob.h"
+#include "DllMacro.h"
+#include "utils/PluginFactory.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+#include <memory>
+
+/** @brief Records a timeline of the whole installation
+ *
+ * From the moment the configuration is loaded (at startup), the pages
+ * that are shown and the jobs of the queue are recorded as spans, one
+ * JSON event per line, in a spool next to the Calamares log. The spool
+ * is named in the CALAMARES_TRACE environment variable, so that others
+ * add to it: jobgraph adds a span per module, on the thread it ran on,
+ * and the Python helper calamares_trace adds one per command.
+ *
+ * When the queue finishes or fails, and when this job runs, the spool
+ * is turned into a Chrome trace (JSON object format), which Perfetto
+ * and chrome://tracing open, with a description of the hardware.
+ *
+ * Each job of the queue also gets its CPU time, storage I/O and peak
+ * RSS (see ResourceMeter), which go into its span and into the install
+ * report, next to the trace: a JSON summary per job, and per module of
+ * jobgraph.
+ *
+ * While the queue runs, an EtaEstimator puts the time left in
+ * GlobalStorage for the slideshow.
+ */
+class PLUGINDLLEXPORT TraceJob : public Calamares::CppJob
+{
+    Q_OBJECT
+
+public:
+    explicit TraceJob( QObject* parent = nullptr );
+    ~TraceJob() override;
+
+    QString prettyName() const override;
+
+    Calamares::JobResult exec() override;
+
+    void setConfigurationMap( const QVariantMap& configurationMap ) override;
+
+private:
+    void append( QJsonObject event, int thread );
+    void begin( int thread, const QString& name, const char* category, const QJsonObject& args = {} );
+    void end( int thread, const QJsonObject& args = {} );
+
+    void stepChanged();
+    void queueChanged( const QStringList& jobNames );
+    void jobProgress( qreal percent, const QString& message );
+    /// @brief Closes the span of the job that runs, with its resources and @p args
+    void jobDone( const QJsonObject& args = {} );
+    /// @brief Closes the trace and the ETA, once, when the queue has finished
+    void queueDone();
+    /// @brief Writes the trace and the report; on the UI thread only
+    void save();
+
+    QString m_spool;  ///< JSON lines, appended to by everyone
+    QString m_output;  ///< The Chrome trace
+    QString m_report;  ///< The install report
+    QString m_step;  ///< The page that is shown, as an open span
+    QStringList m_queue;  ///< Pretty names of the jobs in the queue, in order
+    int m_jobIndex = -1;  ///< Of m_job in m_queue
+    QString m_job;  ///< The job that runs, as an open span
+    qint64 m_jobStart = 0;  ///< Trace clock
+    ResourceUsage m_jobUsage;  ///< At the start of m_job
+    bool m_failed = false;  ///< The queue failed; it finishes after that
+    QString m_failure;  ///< Why it failed
+    QJsonArray m_jobs;  ///< Report entries of the jobs done
+    std::unique_ptr< ResourceMeter > m_meter;
+    std::unique_ptr< EtaEstimator > m_eta;
+};
+
+CALAMARES_PLUGIN_FACTORY_DECLARATION( TraceJobFactory )
+
+#endif  // TRACEJOB_H
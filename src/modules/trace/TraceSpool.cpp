@@ -0,0 +1,48 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "TraceSpool.h"
+
+#include "utils/Logger.h"
+
+#include <QFile>
+#include <QJsonDocument>
+
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace TraceSpool
+{
+
+qint64
+clock()
+{
+    using namespace std::chrono;
+    return duration_cast< microseconds >( steady_clock::now().time_since_epoch() ).count();
+}
+
+void
+append( const QString& path, const QJsonObject& event )
+{
+    const QByteArray line = QJsonDocument( event ).toJson( QJsonDocument::Compact ) + '\n';
+    const int fd = ::open( QFile::encodeName( path ).constData(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644 );
+    if ( fd >= 0 )
+    {
+        // One write, so that lines from other threads and processes do not mix
+        if ( ::write( fd, line.constData(), size_t( line.size() ) ) < 0 )
+        {
+            cWarning() << "Cannot write the install trace" << path;
+        }
+        ::close( fd );
+    }
+}
+
+}  // namespace TraceSpool
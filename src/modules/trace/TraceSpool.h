@@ -0,0 +1,31 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef TRACE_TRACESPOOL_H
+#define TRACE_TRACESPOOL_H
+
+#include <QJsonObject>
+#include <QString>
+
+/** @brief The spool of the install trace, for the modules that add to it
+ *
+ * The spool holds one JSON event per line; the trace module and
+ * jobgraph both append to it, from any thread, and so does the Python
+ * helper calamares_trace, from other processes.
+ */
+namespace TraceSpool
+{
+/// @brief Microseconds on the monotonic clock, the time base of the install trace
+qint64 clock();
+
+/// @brief Appends @p event as a line to the spool at @p path
+void append( const QString& path, const QJsonObject& event );
+}  // namespace TraceSpool
+
+#endif  // TRACE_TRACESPOOL_H
@@ -0,0 +1,389 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "CopyEngine.h"
+
+#include "utils/Logger.h"
+
+#include <QByteArray>
+#include <QFile>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <xxhash.h>
+
+static constexpr qint64 chunkSize = 8 * 1024 * 1024;
+static constexpr qint64 alignment = 4096;  ///< For O_DIRECT; also a page
+
+/// @brief The message for @p error, by default the errno of this thread
+static QString
+errnoString( int error = errno )
+{
+    return QString::fromLocal8Bit( std::strerror( error ) );
+}
+
+/** @brief Is most of [@p offset, @p offset + @p length) of @p fd in the page cache?
+ *
+ * Data that is cached already (read ahead by the Prefetcher) is read
+ * from the cache; O_DIRECT would read it from the medium again.
+ */
+static bool
+isCached( int fd, qint64 offset, qint64 length )
+{
+    const qint64 start = offset / alignment * alignment;
+    const size_t mapped = size_t( offset + length - start );
+    void* map = ::mmap( nullptr, mapped, PROT_READ, MAP_SHARED, fd, start );
+    if ( map == MAP_FAILED )
+    {
+        return false;
+    }
+    std::vector< unsigned char > pages( ( mapped + alignment - 1 ) / alignment );
+    bool cached = false;
+    if ( ::mincore( map, mapped, pages.data() ) == 0 )
+    {
+        size_t resident = 0;
+        for ( unsigned char page : pages )
+        {
+            resident += page & 1;
+        }
+        cached = resident * 2 >= pages.size();
+    }
+    ::munmap( map, mapped );
+    return cached;
+}
+
+namespace
+{
+struct FreeDeleter
+{
+    void operator()( char* p ) const { std::free( p ); }
+};
+using Buffer = std::unique_ptr< char, FreeDeleter >;
+
+/// @brief Closes the descriptors of a copy when it is done, however it ends
+struct Descriptors
+{
+    int* fds[ 3 ];
+    ~Descriptors()
+    {
+        for ( int* fd : fds )
+        {
+            if ( *fd >= 0 )
+            {
+                ::close( *fd );
+                *fd = -1;
+            }
+        }
+    }
+};
+}  // namespace
+
+CopyEngine::CopyEngine( const QString& source, const QString& destination )
+    : m_source( source )
+    , m_destination( destination )
+{
+}
+
+CopyEngine::~CopyEngine()
+{
+    if ( m_hashState )
+    {
+        XXH3_freeState( m_hashState );
+    }
+}
+
+QString
+CopyEngine::copy()
+{
+    Descriptors closer { { &m_in, &m_direct, &m_out } };
+    m_done = 0;
+    m_lastOffset = -1;
+    m_hash.clear();
+    if ( m_hashing )
+    {
+        if ( !m_hashState )
+        {
+            m_hashState = XXH3_createState();
+        }
+        if ( !m_hashState || XXH3_128bits_reset( m_hashState ) != XXH_OK )
+        {
+            return errnoString( ENOMEM );
+        }
+    }
+
+    m_in = ::open( QFile::encodeName( m_source ).constData(), O_RDONLY | O_CLOEXEC );
+    struct stat st;
+    if ( m_in < 0 || ::fstat( m_in, &st ) != 0 )
+    {
+        return errnoString();
+    }
+    m_size = st.st_size;
+    m_out = ::open(
+        QFile::encodeName( m_destination ).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777 );
+    if ( m_out < 0 )
+    {
+        return errnoString();
+    }
+
+    m_method = Method::Reflink;
+    if ( !m_hashing && ::ioctl( m_out, FICLONE, m_in ) == 0 )
+    {
+        skipped( m_size );
+        return QString();
+    }
+    m_method = m_hashing ? Method::Buffered : Method::CopyFileRange;
+    ::posix_fadvise( m_in, 0, 0, POSIX_FADV_SEQUENTIAL );
+
+    // Walk the data regions; everything in between stays a hole
+    qint64 offset = 0;
+    while ( offset < m_size )
+    {
+        qint64 data = ::lseek( m_in, offset, SEEK_DATA );
+        if ( data < 0 && errno == ENXIO )
+        {
+            break;  // Only a hole remains
+        }
+        qint64 dataEnd = data < 0 ? m_size : ::lseek( m_in, data, SEEK_HOLE );
+        if ( data < 0 )
+        {
+            data = offset;  // No SEEK_DATA support: all data
+        }
+        if ( dataEnd < 0 || dataEnd > m_size )
+        {
+            dataEnd = m_size;
+        }
+
+        hole( data - offset );
+        const QString error = copyExtent( data, dataEnd );
+        if ( !error.isEmpty() )
+        {
+            return error;
+        }
+        offset = dataEnd;
+    }
+    hole( m_size - offset );
+
+    // Trailing holes, and the size in general
+    if ( ::ftruncate( m_out, m_size ) != 0 )
+    {
+        return errnoString();
+    }
+    if ( m_hashing )
+    {
+        XXH128_canonical_t canonical;
+        XXH128_canonicalFromHash( &canonical, XXH3_128bits_digest( m_hashState ) );
+        m_hash = QString::fromLatin1(
+            QByteArray( reinterpret_cast< const char* >( canonical.digest ), sizeof( canonical.digest ) ).toHex() );
+    }
+    return QString();
+}
+
+QString
+CopyEngine::copyExtent( qint64 start, qint64 end )
+{
+    return m_method == Method::CopyFileRange ? copyRange( start, end ) : copyBuffered( start, end );
+}
+
+QString
+CopyEngine::copyRange( qint64 start, qint64 end )
+{
+    loff_t inOffset = start;
+    loff_t outOffset = start;
+    while ( inOffset < end )
+    {
+        const qint64 length = qMin( chunkSize, end - inOffset );
+        const loff_t chunkStart = inOffset;
+        const ssize_t n = ::copy_file_range( m_in, &inOffset, m_out, &outOffset, size_t( length ), 0 );
+        if ( n < 0 )
+        {
+            if ( chunkStart == start
+                 && ( errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP || errno == ENOSYS ) )
+            {
+                cDebug() << "copy_file_range not possible for" << m_source << errnoString()
+                         << "- copying through buffers.";
+                m_method = Method::Buffered;
+                return copyBuffered( start, end );
+            }
+            return errnoString();
+        }
+        if ( n == 0 )
+        {
+            break;  // The source shrank
+        }
+        chunkDone( chunkStart, n );
+    }
+    return QString();
+}
+
+QString
+CopyEngine::copyBuffered( qint64 start, qint64 end )
+{
+    if ( m_direct < 0 )
+    {
+        // Reading around the page cache is best on slow media; not all filesystems allow it
+        m_direct = ::open( QFile::encodeName( m_source ).constData(), O_RDONLY | O_DIRECT | O_CLOEXEC );
+    }
+
+    Buffer buffers[ 2 ] { Buffer( static_cast< char* >( std::aligned_alloc( alignment, chunkSize ) ) ),
+                          Buffer( static_cast< char* >( std::aligned_alloc( alignment, chunkSize ) ) ) };
+    if ( !buffers[ 0 ] || !buffers[ 1 ] )
+    {
+        return QString::fromLocal8Bit( std::strerror( ENOMEM ) );
+    }
+
+    // Reads a whole chunk (or up to EOF) at @p offset into buffer @p b; negative is -errno.
+    // It runs on another thread, whose errno is not the caller's.
+    auto readChunk = [ this, &buffers, end ]( int b, qint64 offset ) -> qint64
+    {
+        // O_DIRECT needs aligned lengths; anything read past the end is not written
+        const qint64 wanted = ( ( qMin( chunkSize, end - offset ) + alignment - 1 ) / alignment ) * alignment;
+        const bool cached = m_direct >= 0 && isCached( m_in, offset, wanted );
+        qint64 got = 0;
+        while ( got < wanted )
+        {
+            const int fd = m_direct >= 0 && !cached ? m_direct : m_in;
+            const ssize_t n = ::pread( fd, buffers[ b ].get() + got, size_t( wanted - got ), offset + got );
+            if ( n < 0 && errno == EINVAL && fd == m_direct )
+            {
+                ::close( m_direct );
+                m_direct = -1;
+                continue;
+            }
+            if ( n < 0 && errno == EINTR )
+            {
+                continue;
+            }
+            if ( n < 0 )
+            {
+                return -qint64( errno );
+            }
+            if ( n == 0 )
+            {
+                break;
+            }
+            got += n;
+        }
+        return qMin( got, end - offset );
+    };
+
+    int current = 0;
+    qint64 offset = start;
+    auto pending = std::async( std::launch::async, readChunk, current, offset );
+    while ( offset < end )
+    {
+        const qint64 got = pending.get();
+        if ( got < 0 )
+        {
+            return errnoString( int( -got ) );
+        }
+        if ( got == 0 )
+        {
+            break;
+        }
+
+        // The next chunk is read while this one is written
+        const qint64 next = offset + got;
+        if ( next < end )
+        {
+            pending = std::async( std::launch::async, readChunk, 1 - current, next );
+        }
+
+        qint64 written = 0;
+        while ( written < got )
+        {
+            const ssize_t n
+                = ::pwrite( m_out, buffers[ current ].get() + written, size_t( got - written ), offset + written );
+            if ( n < 0 && errno == EINTR )
+            {
+                continue;
+            }
+            if ( n <= 0 )
+            {
+                const QString error = errnoString();
+                if ( pending.valid() )
+                {
+                    pending.wait();
+                }
+                return error;
+            }
+            written += n;
+        }
+        if ( m_hashing )
+        {
+            XXH3_128bits_update( m_hashState, buffers[ current ].get(), size_t( got ) );
+        }
+        chunkDone( offset, got );
+
+        offset = next;
+        current = 1 - current;
+    }
+    return QString();
+}
+
+void
+CopyEngine::chunkDone( qint64 offset, qint64 length )
+{
+    // The source is not needed again
+    ::posix_fadvise( m_in, offset, length, POSIX_FADV_DONTNEED );
+
+    // Start writing this chunk back, and wait for the previous one;
+    // dirty pages cannot be dropped, written-back ones can.
+    ::sync_file_range( m_out, offset, length, SYNC_FILE_RANGE_WRITE );
+    if ( m_lastOffset >= 0 )
+    {
+        ::sync_file_range( m_out,
+                           m_lastOffset,
+                           m_lastLength,
+                           SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER );
+        ::posix_fadvise( m_out, m_lastOffset, m_lastLength, POSIX_FADV_DONTNEED );
+    }
+    m_lastOffset = offset;
+    m_lastLength = length;
+
+    skipped( length );
+}
+
+void
+CopyEngine::hole( qint64 length )
+{
+    if ( m_hashing )
+    {
+        static const char zeroes[ 64 * 1024 ] = {};
+        for ( qint64 left = length; left > 0; left -= qint64( sizeof( zeroes ) ) )
+        {
+            XXH3_128bits_update( m_hashState, zeroes, size_t( qMin( left, qint64( sizeof( zeroes ) ) ) ) );
+        }
+    }
+    skipped( length );
+}
+
+void
+CopyEngine::skipped( qint64 length )
+{
+    if ( length > 0 )
+    {
+        m_done += length;
+        if ( m_progress )
+        {
+            m_progress( m_done );
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef UNPACKFILE_COPYENGINE_H
+#define UNPACKFILE_COPYENGINE_H
+
+#include <QString>
+
+#include <functional>
+
+struct XXH3_state_s;
+
+/** @brief Copies one large file, as cheaply as the filesystems allow
+ *
+ * In order of preference, the copy is
+ *  - a reflink (FICLONE), when source and destination share a
+ *    copy-on-write filesystem;
+ *  - copy_file_range(), which keeps the data in the kernel;
+ *  - reads into two aligned buffers, one being filled (with O_DIRECT
+ *    where the source allows it, unless the data is in the page cache
+ *    already) while the other is written out.
+ *
+ * Only the data regions of the source (SEEK_DATA / SEEK_HOLE) are
+ * copied, so sparse files stay sparse. Pages of the source and the
+ * destination are dropped from the page cache once they have been
+ * copied and written back, so that copying gigabytes does not push
+ * everything else (like the slideshow) out of memory.
+ *
+ * With hashing on, the XXH3-128 hash of the source is computed on the
+ * buffers as the data passes through, so checking the copy costs no
+ * extra reads. That needs the data in user space, so no reflink or
+ * copy_file_range() is done then; holes are hashed as zeroes.
+ */
+class CopyEngine
+{
+public:
+    enum class Method
+    {
+        Reflink,
+        CopyFileRange,
+        Buffered
+    };
+
+    /// @brief Called with the number of bytes done so far (holes count as done)
+    using Progress = std::function< void( qint64 ) >;
+
+    CopyEngine( const QString& source, const QString& destination );
+    ~CopyEngine();
+
+    void setProgress( const Progress& progress ) { m_progress = progress; }
+    void setHashing( bool hashing ) { m_hashing = hashing; }
+
+    /// @brief Copies the source to the destination; returns an empty string or an explanation
+    QString copy();
+
+    /// @brief Size of the source, known once copy() has started
+    qint64 size() const { return m_size; }
+    /// @brief How the (last part of the) data was copied
+    Method method() const { return m_method; }
+    /// @brief Canonical (xxhsum) hex XXH3-128 of the data copied, if hashing was on
+    QString hash() const { return m_hash; }
+
+private:
+    QString copyExtent( qint64 start, qint64 end );
+    QString copyRange( qint64 start, qint64 end );
+    QString copyBuffered( qint64 start, qint64 end );
+    /// @brief Bookkeeping after [offset, offset + length) has been written
+    void chunkDone( qint64 offset, qint64 length );
+    void skipped( qint64 length );
+    /// @brief Accounts for @p length bytes of zeroes that are not copied
+    void hole( qint64 length );
+
+    QString m_source;
+    QString m_destination;
+    Progress m_progress;
+
+    int m_in = -1;
+    int m_direct = -1;  ///< O_DIRECT descriptor of the source, or -1
+    int m_out = -1;
+    qint64 m_size = 0;
+    qint64 m_done = 0;
+    qint64 m_lastOffset = -1;  ///< Previous chunk, still being written back
+    qint64 m_lastLength = 0;
+    Method m_method = Method::Reflink;
+
+    bool m_hashing = false;
+    XXH3_state_s* m_hashState = nullptr;
+    QString m_hash;
+};
+
+#endif
@@ -0,0 +1,139 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "Prefetcher.h"
+
+#include "utils/Logger.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static constexpr qint64 MiB = 1024 * 1024;
+/// @brief Read ahead this much at a time, between checks for interruption and pressure
+static constexpr qint64 step = 4 * MiB;
+
+// From linux/ioprio.h, which is not in all the kernel headers packages
+static constexpr int ioprioWhoProcess = 1;
+static constexpr int ioprioClassIdle = 3;
+static constexpr int ioprioClassShift = 13;
+
+/// @brief MemAvailable from /proc/meminfo, in bytes, or -1
+static qint64
+memAvailable()
+{
+    QFile file( QStringLiteral( "/proc/meminfo" ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        return -1;
+    }
+    for ( const QByteArray& line : file.readAll().split( '\n' ) )
+    {
+        if ( line.startsWith( "MemAvailable:" ) )
+        {
+            return line.mid( 13 ).trimmed().split( ' ' ).value( 0 ).toLongLong() * 1024;
+        }
+    }
+    return -1;
+}
+
+/// @brief The "some avg10" of /proc/pressure/@p resource, in percent, or 0 without PSI
+static double
+pressure( const char* resource )
+{
+    QFile file( QStringLiteral( "/proc/pressure/" ) + QLatin1String( resource ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        return 0.0;
+    }
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    const QByteArray some = file.readLine();
+    const int start = some.indexOf( "avg10=" );
+    return start < 0 ? 0.0 : some.mid( start + 6 ).split( ' ' ).value( 0 ).toDouble();
+}
+
+Prefetcher::Prefetcher( const QStringList& files, qint64 budget, double pressure, QObject* parent )
+    : QThread( parent )
+    , m_files( files )
+    , m_budget( budget )
+    , m_pressure( pressure )
+{
+}
+
+Prefetcher::~Prefetcher()
+{
+    requestInterruption();
+    wait();
+}
+
+bool
+Prefetcher::waitForCalm()
+{
+    while ( pressure( "memory" ) > m_pressure || pressure( "io" ) > m_pressure )
+    {
+        if ( isInterruptionRequested() )
+        {
+            return false;
+        }
+        msleep( 1000 );
+    }
+    return !isInterruptionRequested();
+}
+
+void
+Prefetcher::run()
+{
+    // Only use the disk when nothing else does (honoured by BFQ)
+    ::syscall( SYS_ioprio_set, ioprioWhoProcess, 0, ioprioClassIdle << ioprioClassShift );
+
+    const qint64 available = memAvailable();
+    const qint64 budget = available > 0 ? qMin( m_budget, available / 2 ) : m_budget;
+
+    // Smallest first: the kernel and ramdisks are small, and needed whole
+    QStringList files = m_files;
+    auto smaller = []( const QString& a, const QString& b ) { return QFileInfo( a ).size() < QFileInfo( b ).size(); };
+    std::stable_sort( files.begin(), files.end(), smaller );
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 done = 0;
+    for ( const QString& path : std::as_const( files ) )
+    {
+        const int fd = ::open( QFile::encodeName( path ).constData(), O_RDONLY | O_CLOEXEC );
+        if ( fd < 0 )
+        {
+            continue;
+        }
+        const qint64 size = QFileInfo( path ).size();
+        for ( qint64 offset = 0; offset < size && done < budget; offset += step )
+        {
+            if ( !waitForCalm() )
+            {
+                ::close( fd );
+                cDebug() << "Prefetch stopped after" << done / MiB << "MiB in" << timer.elapsed() << "ms";
+                return;
+            }
+            const qint64 length = qMin( qMin( step, size - offset ), budget - done );
+            // readahead() returns when the data is in; WILLNEED is for filesystems without it
+            if ( ::readahead( fd, offset, size_t( length ) ) != 0 )
+            {
+                ::posix_fadvise( fd, offset, length, POSIX_FADV_WILLNEED );
+            }
+            done += length;
+        }
+        ::close( fd );
+    }
+    cDebug() << "Prefetched" << done / MiB << "MiB of the install media in" << timer.elapsed() << "ms";
+}
@@ -0,0 +1,49 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef UNPACKFILE_PREFETCHER_H
+#define UNPACKFILE_PREFETCHER_H
+
+#include <QStringList>
+#include <QThread>
+
+/** @brief Reads the install media into the page cache while the user is busy
+ *
+ * The interactive pages take minutes, in which the (often slow) install
+ * medium sits idle. This thread reads the files to be copied ahead,
+ * smallest first, so that the kernel and ramdisks are certainly cached
+ * and as much of the system image as the budget allows.
+ *
+ * It stays out of the way: it runs with idle CPU and I/O priority,
+ * never takes more than half of the available memory, pauses while
+ * the memory or I/O pressure (PSI) is high, and stops for good when it
+ * is interrupted -- which UnpackFileJob does when the job queue starts.
+ */
+class Prefetcher : public QThread
+{
+    Q_OBJECT
+
+public:
+    /// @brief Prefetches @p files, up to @p budget bytes; pauses above @p pressure percent (avg10)
+    Prefetcher( const QStringList& files, qint64 budget, double pressure, QObject* parent = nullptr );
+    ~Prefetcher() override;
+
+protected:
+    void run() override;
+
+private:
+    /// @brief Waits while the system is under pressure; false when interrupted meanwhile
+    bool waitForCalm();
+
+    QStringList m_files;
+    qint64 m_budget;  ///< Bytes
+    double m_pressure;
+};
+
+#endif  // UNPACKFILE_PREFETCHER_H
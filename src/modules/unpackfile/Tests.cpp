@@ -0,0 +1,221 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "CopyEngine.h"
+#include "UnpackFileJob.h"
+
+#include "GlobalStorage.h"
+#include "JobQueue.h"
+#include "utils/Logger.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr qint64 MiB = 1024 * 1024;
+
+/// @brief XXH3-128 (as xxhsum prints it) of the file that makeSparseFile() makes
+static const char sparseHash[] = "8dae978cef880923dbe3305ed77b0555";
+
+static qint64
+blocks( const QString& path )
+{
+    struct stat st;
+    return ::stat( QFile::encodeName( path ).constData(), &st ) == 0 ? qint64( st.st_blocks ) : -1;
+}
+
+/** @brief Makes a 3 MiB file at @p path: a MiB of hole, a MiB of data, a MiB of hole
+ *
+ * The data is byte i = i % 251. Returns the number of 512-byte blocks
+ * of the file, or -1.
+ */
+static qint64
+makeSparseFile( const QString& path )
+{
+    QByteArray data( MiB, Qt::Uninitialized );
+    for ( int i = 0; i < data.size(); ++i )
+    {
+        data[ i ] = char( i % 251 );
+    }
+    const int fd = ::open( QFile::encodeName( path ).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+    if ( fd < 0 )
+    {
+        return -1;
+    }
+    const bool ok = ::pwrite( fd, data.constData(), size_t( data.size() ), MiB ) == data.size()
+        && ::ftruncate( fd, 3 * MiB ) == 0;
+    ::close( fd );
+    return ok ? blocks( path ) : -1;
+}
+
+static QByteArray
+contents( const QString& path )
+{
+    QFile f( path );
+    return f.open( QIODevice::ReadOnly ) ? f.readAll() : QByteArray();
+}
+
+class UnpackFileTests : public QObject
+{
+    Q_OBJECT
+public:
+    UnpackFileTests() {}
+    ~UnpackFileTests() override {}
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testSparseCopy_data();
+    void testSparseCopy();
+    void testChecksumMismatch();
+    void testMissingManifest();
+
+private:
+    Calamares::JobQueue* m_jobQueue = nullptr;  // UnpackFileJob reads GlobalStorage
+};
+
+void
+UnpackFileTests::initTestCase()
+{
+    Logger::setupLogLevel( Logger::LOGVERBOSE );
+    m_jobQueue = new Calamares::JobQueue( this );
+}
+
+void
+UnpackFileTests::testSparseCopy_data()
+{
+    QTest::addColumn< bool >( "hashing" );
+
+    // Without hashing, the copy may be a reflink or copy_file_range();
+    // with it, the data always goes through the buffers.
+    QTest::newRow( "copy" ) << false;
+    QTest::newRow( "hashed" ) << true;
+}
+
+void
+UnpackFileTests::testSparseCopy()
+{
+    QFETCH( bool, hashing );
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString source = dir.filePath( QStringLiteral( "system.img" ) );
+    const QString destination = dir.filePath( QStringLiteral( "copy.img" ) );
+    const qint64 sourceBlocks = makeSparseFile( source );
+    QVERIFY( sourceBlocks >= 0 );
+    if ( sourceBlocks * 512 >= 3 * MiB )
+    {
+        QSKIP( "The temporary directory does not keep holes." );
+    }
+
+    CopyEngine engine( source, destination );
+    engine.setHashing( hashing );
+    qint64 done = 0;
+    engine.setProgress( [ &done ]( qint64 bytes ) { done = bytes; } );
+    QCOMPARE( engine.copy(), QString() );
+
+    QCOMPARE( engine.size(), 3 * MiB );
+    QCOMPARE( done, 3 * MiB );
+    QCOMPARE( QFileInfo( destination ).size(), 3 * MiB );
+    QCOMPARE( contents( destination ), contents( source ) );
+    // Both holes stay holes
+    QCOMPARE( blocks( destination ), sourceBlocks );
+    if ( hashing )
+    {
+        QCOMPARE( engine.method(), CopyEngine::Method::Buffered );
+        QCOMPARE( engine.hash(), QString::fromLatin1( sparseHash ) );
+    }
+    else
+    {
+        QVERIFY( engine.hash().isEmpty() );
+    }
+}
+
+void
+UnpackFileTests::testChecksumMismatch()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString source = dir.filePath( QStringLiteral( "system.img" ) );
+    QVERIFY( makeSparseFile( source ) >= 0 );
+    const QString root = dir.filePath( QStringLiteral( "root" ) );
+    QVERIFY( QDir().mkpath( root ) );
+
+    // One bit off from the real hash
+    QByteArray wrong( sparseHash );
+    wrong[ wrong.size() - 1 ] = '4';
+    QFile manifest( dir.filePath( QStringLiteral( "checksums.xxh128" ) ) );
+    QVERIFY( manifest.open( QIODevice::WriteOnly ) );
+    manifest.write( wrong + "  system.img\n" );
+    manifest.close();
+
+    m_jobQueue->globalStorage()->insert( "rootMountPoint", root );
+    UnpackFileJob job;
+    job.setConfigurationMap( QVariantMap {
+        { "unpack", QVariantList { QVariantMap { { "source", source }, { "destination", "/" } } } },
+        { "manifest", manifest.fileName() },
+        { "prefetch", QVariantMap { { "enabled", false } } },
+    } );
+    const auto result = job.exec();
+    QVERIFY( !result );
+    QVERIFY( !QFileInfo::exists( QDir( root ).filePath( QStringLiteral( "system.img" ) ) ) );
+
+    // With the right hash, the copy stays
+    QVERIFY( manifest.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+    manifest.write( QByteArray( sparseHash ) + "  system.img\n" );
+    manifest.close();
+    QVERIFY( job.exec() );
+    QCOMPARE( contents( QDir( root ).filePath( QStringLiteral( "system.img" ) ) ), contents( source ) );
+}
+
+void
+UnpackFileTests::testMissingManifest()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString source = dir.filePath( QStringLiteral( "system.img" ) );
+    QVERIFY( makeSparseFile( source ) >= 0 );
+    const QString root = dir.filePath( QStringLiteral( "root" ) );
+    QVERIFY( QDir().mkpath( root ) );
+    const QString copy = QDir( root ).filePath( QStringLiteral( "system.img" ) );
+
+    m_jobQueue->globalStorage()->insert( "rootMountPoint", root );
+    QVariantMap configuration {
+        { "unpack", QVariantList { QVariantMap { { "source", source }, { "destination", "/" } } } },
+        { "manifest", dir.filePath( QStringLiteral( "checksums.xxh128" ) ) },
+        { "prefetch", QVariantMap { { "enabled", false } } },
+    };
+    {
+        UnpackFileJob job;
+        job.setConfigurationMap( configuration );
+        const auto result = job.exec();
+        QVERIFY( !result );
+        QVERIFY( result.details().contains( QStringLiteral( "checksums.xxh128" ) ) );
+        QVERIFY( !QFileInfo::exists( copy ) );
+    }
+
+    // Unless it is optional, when the copy is not verified
+    configuration.insert( "manifestOptional", true );
+    UnpackFileJob job;
+    job.setConfigurationMap( configuration );
+    QVERIFY( job.exec() );
+    QCOMPARE( contents( copy ), contents( source ) );
+}
+
+QTEST_GUILESS_MAIN( UnpackFileTests )
+
+#include "utils/moc-warnings.h"
+
+#include "Tests.moc"
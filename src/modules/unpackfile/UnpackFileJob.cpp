@@ -0,0 +1,238 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "UnpackFileJob.h"
+
+#include "CopyEngine.h"
+#include "Prefetcher.h"
+
+#include "GlobalStorage.h"
+#include "JobQueue.h"
+#include "utils/Logger.h"
+#include "utils/Variant.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+
+static constexpr qint64 MiB = 1024 * 1024;
+
+static const char*
+methodName( CopyEngine::Method m )
+{
+    switch ( m )
+    {
+    case CopyEngine::Method::Reflink:
+        return "reflink";
+    case CopyEngine::Method::CopyFileRange:
+        return "copy_file_range";
+    case CopyEngine::Method::Buffered:
+        return "buffered";
+    }
+    return "";
+}
+
+/** @brief Reads an xxhsum-style manifest: lines of "<hex hash>  [*]<file name>"
+ *
+ * @p hashes maps file names (without directory) to lower-case hashes.
+ * Returns an empty string on success, or why the manifest cannot be read.
+ */
+static QString
+loadManifest( const QString& path, QHash< QString, QString >& hashes )
+{
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        return file.errorString();
+    }
+
+    static const QRegularExpression line( QStringLiteral( "^([0-9a-fA-F]{32})\\s+\\*?(.+)$" ) );
+    while ( !file.atEnd() )
+    {
+        const auto match = line.match( QString::fromUtf8( file.readLine() ).trimmed() );
+        if ( match.hasMatch() )
+        {
+            hashes.insert( QFileInfo( match.captured( 2 ) ).fileName(), match.captured( 1 ).toLower() );
+        }
+    }
+    return file.error() == QFileDevice::NoError ? QString() : file.errorString();
+}
+
+UnpackFileJob::UnpackFileJob( QObject* parent )
+    : Calamares::CppJob( parent )
+{
+}
+
+UnpackFileJob::~UnpackFileJob() {}
+
+QString
+UnpackFileJob::prettyName() const
+{
+    return tr( "Copying system files." );
+}
+
+Calamares::JobResult
+UnpackFileJob::exec()
+{
+    auto* gs = Calamares::JobQueue::instance()->globalStorage();
+    const QString rootPath = gs ? gs->value( "rootMountPoint" ).toString() : QString();
+    if ( rootPath.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "No mount point for root partition" ),
+                                            tr( "globalstorage does not contain a \"rootMountPoint\" key." ) );
+    }
+    const QDir root( rootPath );
+    if ( !root.exists() )
+    {
+        return Calamares::JobResult::error( tr( "Bad mount point for root partition" ),
+                                            tr( "rootMountPoint is \"%1\", which does not exist." ).arg( rootPath ) );
+    }
+    if ( m_entries.isEmpty() )
+    {
+        return Calamares::JobResult::error( tr( "Bad unpackfile configuration" ),
+                                            tr( "There is no configuration information." ) );
+    }
+
+    // All the sources must be there before anything is copied
+    qint64 total = 0;
+    QStringList destinations;
+    for ( const auto& entry : std::as_const( m_entries ) )
+    {
+        const QFileInfo source( entry.source );
+        if ( !source.isFile() )
+        {
+            return Calamares::JobResult::error( tr( "Bad unpackfile configuration" ),
+                                                tr( "The source file \"%1\" does not exist." ).arg( entry.source ) );
+        }
+        total += source.size();
+
+        QString destination = root.filePath( entry.destination.mid( entry.destination.startsWith( '/' ) ? 1 : 0 ) );
+        if ( destination.endsWith( '/' ) || QFileInfo( destination ).isDir() )
+        {
+            destination = QDir( destination ).filePath( source.fileName() );
+        }
+        destinations.append( destination );
+    }
+
+    if ( m_prefetcher )
+    {
+        m_prefetcher->requestInterruption();
+        m_prefetcher->wait();
+    }
+
+    // The manifest is on the same medium as the sources, so an unreadable one is as bad as a damaged image
+    QHash< QString, QString > manifest;
+    const QString manifestError = m_manifest.isEmpty() ? QString() : loadManifest( m_manifest, manifest );
+    if ( !manifestError.isEmpty() && m_manifestOptional )
+    {
+        cWarning() << "Cannot read the checksum manifest" << m_manifest << manifestError
+                   << "- the copies are not verified.";
+    }
+    else if ( !manifestError.isEmpty() )
+    {
+        cWarning() << "Cannot read the checksum manifest" << m_manifest << manifestError;
+        return Calamares::JobResult::error(
+            tr( "The installation medium is damaged" ),
+            tr( "The checksum manifest \"%1\" cannot be read: %2. Try another USB stick or image." )
+                .arg( m_manifest, manifestError ) );
+    }
+
+    qint64 done = 0;
+    for ( int i = 0; i < m_entries.count(); ++i )
+    {
+        const QString& source = m_entries.at( i ).source;
+        const QString& destination = destinations.at( i );
+        QDir().mkpath( QFileInfo( destination ).absolutePath() );
+
+        const QString expected = manifest.value( QFileInfo( source ).fileName() );
+        CopyEngine engine( source, destination );
+        engine.setHashing( !expected.isEmpty() );
+        engine.setProgress( [ this, done, total ]( qint64 bytes )
+                            { emit progress( total > 0 ? qreal( done + bytes ) / total : 0.0 ); } );
+
+        QElapsedTimer timer;
+        timer.start();
+        const QString error = engine.copy();
+        if ( !error.isEmpty() )
+        {
+            cWarning() << "Copying" << source << "to" << destination << "failed:" << error;
+            return Calamares::JobResult::error( tr( "Could not copy system files" ),
+                                                tr( "Copying \"%1\" failed: %2" ).arg( source, error ) );
+        }
+        cDebug() << "Copied" << source << engine.size() / MiB << "MiB by" << methodName( engine.method() ) << "in"
+                 << timer.elapsed() << "ms";
+        if ( !expected.isEmpty() && engine.hash() != expected )
+        {
+            // Nothing later may use a damaged copy
+            QFile::remove( destination );
+            cWarning() << "Checksum mismatch for" << source << "expected" << expected << "got" << engine.hash();
+            return Calamares::JobResult::error(
+                tr( "The installation medium is damaged" ),
+                tr( "The data read from \"%1\" does not match the checksum in \"%2\" "
+                    "(XXH3-128 %3 expected, %4 read). Try another USB stick or image." )
+                    .arg( source, m_manifest, expected, engine.hash() ) );
+        }
+        done += engine.size();
+    }
+
+    emit progress( 1.0 );
+    return Calamares::JobResult::ok();
+}
+
+void
+UnpackFileJob::setConfigurationMap( const QVariantMap& configurationMap )
+{
+    m_entries.clear();
+    m_manifest = Calamares::getString( configurationMap, "manifest" );
+    m_manifestOptional = Calamares::getBool( configurationMap, "manifestOptional", false );
+    for ( const auto& v : configurationMap.value( "unpack" ).toList() )
+    {
+        const QVariantMap map = v.toMap();
+        Entry entry { Calamares::getString( map, "source" ), Calamares::getString( map, "destination" ) };
+        if ( entry.source.isEmpty() )
+        {
+            cWarning() << "unpackfile entry" << map << "needs a *source*.";
+            continue;
+        }
+        m_entries.append( entry );
+    }
+    if ( m_entries.isEmpty() )
+    {
+        cWarning() << "No *unpack* entries in job configuration.";
+    }
+
+    delete m_prefetcher;
+    m_prefetcher = nullptr;
+    bool ok = false;
+    const QVariantMap prefetch = Calamares::getSubMap( configurationMap, "prefetch", ok );
+    if ( m_entries.isEmpty() || !Calamares::getBool( prefetch, "enabled", true ) )
+    {
+        return;
+    }
+    QStringList sources;
+    for ( const auto& entry : std::as_const( m_entries ) )
+    {
+        sources.append( entry.source );
+    }
+    m_prefetcher = new Prefetcher( sources,
+                                   Calamares::getInteger( prefetch, "budget", 2048 ) * MiB,
+                                   Calamares::getDouble( prefetch, "pressure", 10.0 ),
+                                   this );
+    // Installing needs the disks more than the prefetch does
+    if ( auto* queue = Calamares::JobQueue::instance() )
+    {
+        connect( queue, &Calamares::JobQueue::progress, m_prefetcher, &QThread::requestInterruption );
+    }
+    m_prefetcher->start( QThread::IdlePriority );
+}
+
+CALAMARES_PLUGIN_FACTORY_DEFINITION( UnpackFileJobFactory, registerPlugin< UnpackFileJob >(); )
@@ -0,0 +1,64 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef UNPACKFILEJOB_H
+#define UNPACKFILEJOB_H
+
+#include "CppJob.h"
+#include "DllMacro.h"
+#include "utils/PluginFactory.h"
+
+#include <QList>
+#include <QObject>
+#include <QVariantMap>
+
+class Prefetcher;
+
+/** @brief Copies the system image, kernel and ramdisks to the target
+ *
+ * This takes over the `sourcefs: file` entries of unpackfs, with a
+ * CopyEngine per file instead of rsync. Progress is in bytes, over
+ * all of the files.
+ *
+ * Files listed in the checksum manifest are hashed as they are copied,
+ * and a copy that does not match is removed and fails the job. So does
+ * a manifest that cannot be read, unless it is optional.
+ *
+ * From the moment the configuration is loaded (at startup) until the
+ * job queue starts, a Prefetcher reads the sources into the page cache.
+ */
+class PLUGINDLLEXPORT UnpackFileJob : public Calamares::CppJob
+{
+    Q_OBJECT
+
+public:
+    explicit UnpackFileJob( QObject* parent = nullptr );
+    ~UnpackFileJob() override;
+
+    QString prettyName() const override;
+
+    Calamares::JobResult exec() override;
+
+    void setConfigurationMap( const QVariantMap& configurationMap ) override;
+
+private:
+    struct Entry
+    {
+        QString source;
+        QString destination;  ///< Relative to rootMountPoint
+    };
+    QList< Entry > m_entries;
+    QString m_manifest;  ///< Path to the XXH3-128 checksums, may be empty
+    bool m_manifestOptional = false;  ///< Copy unverified when m_manifest cannot be read
+    Prefetcher* m_prefetcher = nullptr;
+};
+
+CALAMARES_PLUGIN_FACTORY_DECLARATION( UnpackFileJobFactory )
+
+#endif  // UNPACKFILEJOB_H
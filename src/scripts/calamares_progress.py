@@ -0,0 +1,109 @@
+# -*- coding: utf-8 -*-
+#
+# === This file is part of Calamares - <https://calamares.io> ===
+#
+#   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+#   SPDX-License-Identifier: GPL-3.0-or-later
+#
+#   Calamares is Free Software: see the License-Identifier above.
+#
+
+"""
+Runs a command with a progress pipe, and passes its progress on to the
+job with libcalamares.job.setprogress().
+
+The command gets the write end of a pipe, named in CALAMARES_PROGRESS_FD,
+on which it writes lines of "<done> <total> [<message>]" (see
+progress.sh for scripts). Its output goes to the log, as with
+libcalamares.utils.host_env_process_output().
+"""
+
+import os
+import selectors
+import subprocess
+import time
+
+import libcalamares
+
+# Changes of progress smaller than this are not passed on
+GRANULARITY = 0.005
+
+
+def run(command, start=0.0, end=1.0, status=None):
+    """
+    Runs @p command on the host. Its progress is mapped into the range
+    from @p start to @p end of the job's progress; @p status, when
+    given, is called with the messages. Raises CalledProcessError when
+    the command fails.
+    """
+    read_fd, write_fd = os.pipe()
+    env = dict(os.environ, CALAMARES_PROGRESS_FD=str(write_fd))
+    began = time.monotonic_ns()
+    try:
+        process = subprocess.Popen(
+            command,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+            pass_fds=(write_fd,),
+            env=env,
+        )
+    finally:
+        os.close(write_fd)
+
+    selector = selectors.DefaultSelector()
+    selector.register(process.stdout, selectors.EVENT_READ, "output")
+    selector.register(read_fd, selectors.EVENT_READ, "progress")
+    pending = {"output": b"", "progress": b""}
+    reported = -1.0
+
+    def handle(kind, line):
+        nonlocal reported
+        text = line.decode(errors="replace").rstrip()
+        if kind == "output":
+            libcalamares.utils.debug(text)
+            return
+        fields = text.split(" ", 2)
+        try:
+            done, total = int(fields[0]), int(fields[1])
+        except (IndexError, ValueError):
+            return
+        if total <= 0:
+            return
+        fraction = min(max(done / total, 0.0), 1.0)
+        if status and len(fields) > 2 and fields[2]:
+            status(fields[2])
+        if fraction - reported >= GRANULARITY or (fraction >= 1.0 and reported < 1.0):
+            reported = fraction
+            libcalamares.job.setprogress(start + (end - start) * fraction)
+
+    while selector.get_map():
+        for key, _ in selector.select():
+            fd = key.fd
+            data = os.read(fd, 65536)
+            if not data:
+                selector.unregister(key.fileobj)
+                if pending[key.data]:
+                    handle(key.data, pending[key.data])
+                continue
+            lines = (pending[key.data] + data).split(b"\n")
+            pending[key.data] = lines.pop()
+            for line in lines:
+                handle(key.data, line)
+    selector.close()
+    os.close(read_fd)
+    process.stdout.close()
+    returncode = process.wait()
+
+    try:
+        import calamares_trace
+
+        calamares_trace.span(
+            os.path.basename(str(command[0])), "process", began, time.monotonic_ns(),
+            {"function": "calamares_progress.run", "command": " ".join(str(a) for a in command),
+             "result": returncode})
+    except ImportError:
+        pass
+
+    if returncode != 0:
+        raise subprocess.CalledProcessError(returncode, command)
+    libcalamares.job.setprogress(end)
@@ -0,0 +1,101 @@
+# -*- coding: utf-8 -*-
+#
+# === This file is part of Calamares - <https://calamares.io> ===
+#
+#   SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+#   SPDX-License-Identifier: GPL-3.0-or-later
+#
+#   Calamares is Free Software: see the License-Identifier above.
+#
+
+"""
+Adds the commands that Python modules run to the install trace.
+
+The trace module names its spool in CALAMARES_TRACE. install() wraps
+the functions of libcalamares.utils that run commands, so that each
+call appends a span (a Chrome trace "X" event) with the command line
+and its result. The wrappers stay on libcalamares.utils, so later
+Python jobs that call those functions are traced too.
+"""
+
+import functools
+import json
+import os
+import threading
+import time
+
+import libcalamares
+
+TRACED = (
+    "host_env_process_output",
+    "target_env_call",
+    "check_target_env_call",
+    "check_target_env_output",
+    "target_env_process_output",
+    "mount",
+)
+
+
+def span(name, category, start, end, args):
+    """
+    Appends a span from @p start to @p end (monotonic nanoseconds).
+    """
+    spool = os.environ.get("CALAMARES_TRACE")
+    if not spool:
+        return
+    event = {
+        "name": name,
+        "cat": category,
+        "ph": "X",
+        "ts": start // 1000,
+        "dur": (end - start) // 1000,
+        "pid": os.getpid(),
+        "tid": threading.get_native_id(),
+        "args": args,
+    }
+    try:
+        fd = os.open(spool, os.O_WRONLY | os.O_APPEND | os.O_CREAT | os.O_CLOEXEC, 0o644)
+        try:
+            # One write, so that lines from other threads do not mix
+            os.write(fd, (json.dumps(event) + "\n").encode())
+        finally:
+            os.close(fd)
+    except OSError:
+        pass
+
+
+def _traced(name, function):
+    @functools.wraps(function)
+    def wrapper(*args, **kwargs):
+        command = args[0] if args else kwargs.get("command", [])
+        if isinstance(command, (list, tuple)):
+            argv = [str(a) for a in command]
+        else:
+            argv = [str(command)]
+        start = time.monotonic_ns()
+        result = "exception"
+        try:
+            value = function(*args, **kwargs)
+            result = value if isinstance(value, int) else "ok"
+            return value
+        finally:
+            title = name if name == "mount" or not argv else os.path.basename(argv[0])
+            span(title, "process", start, time.monotonic_ns(),
+                 {"function": name, "command": " ".join(argv), "result": result})
+
+    wrapper.calamares_traced = True
+    return wrapper
+
+
+def install():
+    """
+    Wraps the command functions of libcalamares.utils; does nothing
+    when there is no trace, or when they are wrapped already.
+    """
+    if not os.environ.get("CALAMARES_TRACE"):
+        return
+    for name in TRACED:
+        function = getattr(libcalamares.utils, name, None)
+        if function is None or getattr(function, "calamares_traced", False):
+            continue
+        setattr(libcalamares.utils, name, _traced(name, function))
@@ -0,0 +1,38 @@
+#!/bin/sh
+# SPDX-FileCopyrightText: 2024 Bùi Gia Viện (BlissLabs) <shadichy@blisslabs.org>
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Progress reporting for the scripts that Calamares jobs run; source it.
+#
+# The job runner (calamares_progress.py) opens a pipe and names its
+# file descriptor in CALAMARES_PROGRESS_FD. Each line on it is
+#
+#   <done> <total> [<message>]
+#
+# with <done> and <total> whole numbers in any unit (bytes, for copies),
+# and an optional status message for the rest of the line. A line is a
+# single write, and the runner only passes on changes of 0.5% or more,
+# so reporting every few MB costs nothing measurable. Without
+# CALAMARES_PROGRESS_FD (run by hand), nothing is written.
+
+# progress DONE TOTAL [MESSAGE...]
+progress() {
+	[ -n "$CALAMARES_PROGRESS_FD" ] || return 0
+	_progress_done=$1
+	_progress_total=$2
+	shift 2
+	{ printf '%s %s %s\n' "$_progress_done" "$_progress_total" "$*" >&"$CALAMARES_PROGRESS_FD"; } 2>/dev/null || :
+}
+
+# For scripts made of a known number of steps:
+#   progress_steps COUNT, then progress_next [MESSAGE...] after each step
+progress_steps() {
+	_progress_step=0
+	_progress_steps=$1
+	progress 0 "$_progress_steps"
+}
+
+progress_next() {
+	_progress_step=$((_progress_step + 1))
+	progress "$_progress_step" "$_progress_steps" "$@"
+}